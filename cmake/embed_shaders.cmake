@@ -0,0 +1,50 @@
+# Writes every *.shader in SHADER_DIR into OUTPUT as a C++ header, so the application carries its shaders.
+#	cmake -DSHADER_DIR=<directory> -DOUTPUT=<header> -P embed_shaders.cmake
+# The header is only rewritten when its contents change, so unchanged shaders don't rebuild anything
+
+if(NOT SHADER_DIR OR NOT OUTPUT)
+	message(FATAL_ERROR "Usage : cmake -DSHADER_DIR=<directory> -DOUTPUT=<header> -P embed_shaders.cmake")
+endif()
+
+file(GLOB SHADER_PATHS "${SHADER_DIR}/*.shader")
+list(SORT SHADER_PATHS)
+
+set(HEADER "// Generated from the shaders in rubiks_cube/res by cmake/embed_shaders.cmake, edits are overwritten\n\n")
+string(APPEND HEADER "#ifndef EMBEDDED_SHADERS_H\n#define EMBEDDED_SHADERS_H\n\n")
+string(APPEND HEADER "struct EmbeddedShader\n{\n\tconst char* name;\n\tconst char* source;\n};\n\n")
+string(APPEND HEADER "constexpr EmbeddedShader EMBEDDED_SHADERS[]\n{\n")
+
+foreach(SHADER_PATH ${SHADER_PATHS})
+	get_filename_component(SHADER_NAME ${SHADER_PATH} NAME)
+	file(READ ${SHADER_PATH} SOURCE)
+
+	if(SOURCE MATCHES "\\)shader\"")
+		message(FATAL_ERROR "${SHADER_PATH} contains the raw string delimiter )shader\"")
+	endif()
+
+	# MSVC caps a single string literal at 16K characters, adjacent ones are joined
+	set(LITERALS "")
+	string(LENGTH "${SOURCE}" SOURCE_LENGTH)
+	set(OFFSET 0)
+	while(OFFSET LESS SOURCE_LENGTH)
+		string(SUBSTRING "${SOURCE}" ${OFFSET} 8192 CHUNK)
+		string(APPEND LITERALS "R\"shader(${CHUNK})shader\"")
+		math(EXPR OFFSET "${OFFSET} + 8192")
+	endwhile()
+
+	if(LITERALS STREQUAL "")
+		set(LITERALS "\"\"")
+	endif()
+
+	string(APPEND HEADER "\t{\"${SHADER_NAME}\", ${LITERALS}},\n")
+endforeach()
+
+string(APPEND HEADER "};\n\n#endif\n")
+
+if(EXISTS ${OUTPUT})
+	file(READ ${OUTPUT} CURRENT_HEADER)
+endif()
+
+if(NOT CURRENT_HEADER STREQUAL HEADER)
+	file(WRITE ${OUTPUT} "${HEADER}")
+endif()
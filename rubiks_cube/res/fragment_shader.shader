@@ -1,10 +1,14 @@
-#version 460 core
+#version 450 core
 
-in vec4 vertexColor;
+const int NUM_COLORS = 7;
+
+uniform vec4 u_palette[NUM_COLORS];
+
+flat in uint colorIndex;
 
 out vec4 color;
 
 void main()
 {
-	color = vertexColor;
+	color = u_palette[colorIndex];
 }
\ No newline at end of file
@@ -1,16 +1,38 @@
-#version 460 core
+#version 450 core
 
 uniform mat4 u_projectionMatrix;
-uniform mat4 u_modelMatrix;
 uniform mat4 u_viewMatrix;
 
+struct TransformInstance
+{
+	vec4 rotation;
+	vec4 position;
+};
+
+layout(std430, binding = 0) readonly buffer TransformInstances
+{
+	TransformInstance transformInstances[];
+};
+
 layout(location = 0) in vec3 i_position;
-layout(location = 1) in vec4 i_color;
+layout(location = 1) in uint i_transform;
+layout(location = 2) in uint i_color;
 
-out vec4 vertexColor;
+// Where the cube's transforms start, one per draw
+layout(location = 3) in uint i_firstTransform;
+
+flat out uint colorIndex;
+
+vec3 rotate(vec4 quaternion, vec3 v)
+{
+	return v + 2.0f * cross(quaternion.xyz, cross(quaternion.xyz, v) + quaternion.w * v);
+}
 
 void main()
 {
-	gl_Position = u_projectionMatrix * u_viewMatrix * u_modelMatrix * vec4(i_position, 1.0f);
-	vertexColor = i_color;
+	TransformInstance transform = transformInstances[i_firstTransform + i_transform];
+	vec3 modelPosition = rotate(transform.rotation, i_position) + transform.position.xyz;
+
+	gl_Position = u_projectionMatrix * u_viewMatrix * vec4(modelPosition, 1.0f);
+	colorIndex = i_color;
 }
\ No newline at end of file
@@ -1,96 +1,197 @@
 #include "application.h"
+#include "frame_capture.h"
+#include "notation.h"
+#include "trace.h"
 
 #include <glm/gtc/type_ptr.hpp>
 
-Application::Application() :
-	SCREEN_WIDTH{1280}, SCREEN_HEIGHT{720}, window{initialize(SCREEN_WIDTH, SCREEN_HEIGHT, "Rubik's Cube", 4, 6)},
-	keys{window},
-	MOUSE_SENSITIVITY{6.0f}, camera{glm::radians(45.0f), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT, 0.1f, 100.0f},
-	rubiksCube{}, ROTATION_SPEED_RADS{glm::radians(90.0f)},
-	shaderProgram{createShaderProgram("../res/vertex_shader.shader", "../res/fragment_shader.shader")},
-	u_modelMatrix{(unsigned int)glGetUniformLocation(shaderProgram, "u_modelMatrix")},
+#include <stddef.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <thread>
+
+namespace
+{
+	// Distance between the centers of neighbouring cubes of a wall, in half extents of a cube
+	constexpr float WALL_SPACING = 3.5f;
+
+	// Far beyond what reaching the target length takes
+	constexpr float FIXED_STEP_SOLVE_SECONDS = 3600.0f;
+
+	// In the order of Application::Phase
+	constexpr const char* PHASE_NAMES[] =
+	{
+		"events",
+		"keys",
+		"simulation",
+		"capture",
+		"step",
+		"draw",
+		"swap",
+		"frame",
+		"gpu"
+	};
+
+	// Frames a timer query has to finish before its result is read, more than the driver queues up
+	constexpr int NUM_GPU_QUERIES = 4;
+
+	constexpr double PROFILE_OVERLAY_SECONDS = 0.5;
+
+	double milliseconds(FrameProfiler::Clock::duration duration)
+	{
+		return std::chrono::duration<double, std::milli>{duration}.count();
+	}
+
+	// Close to square on screen
+	int wallColumns(int wallCubes, float aspectRatio)
+	{
+		return std::max(1, std::min(wallCubes, (int)ceilf(sqrtf(wallCubes * aspectRatio))));
+	}
+
+	int wallRows(int wallCubes, float aspectRatio)
+	{
+		int columns = wallColumns(wallCubes, aspectRatio);
+		return (wallCubes + columns - 1) / columns;
+	}
+
+	// How much further the camera sits than for a single 3x3x3, so a cube of any size, or the whole wall, fills the same
+	// part of the view
+	float viewScale(int cubeSize, int wallColumns, int wallRows, float aspectRatio)
+	{
+		float wallScale = std::max(1.0f, std::max((float)wallRows, wallColumns / aspectRatio));
+		return wallScale * RubiksCube::halfExtent(cubeSize) / RubiksCube::halfExtent(RubiksCube::DEFAULT_SIZE);
+	}
+
+	unsigned int createCubeProgram(const char* shaderDirectory)
+	{
+		std::string vertexSource, fragmentSource;
+		if(!loadShader("vertex_shader.shader", shaderDirectory, vertexSource) ||
+		   !loadShader("fragment_shader.shader", shaderDirectory, fragmentSource))
+			return 0;
+
+		return createShaderProgram(vertexSource.c_str(), fragmentSource.c_str(), "shader_program.cache");
+	}
+}
+
+Application::Application(int screenWidth, int screenHeight, bool headless, int cubeSize, int wallCubes,
+						 const char* shaderDirectory) :
+	SCREEN_WIDTH{screenWidth}, SCREEN_HEIGHT{screenHeight},
+	window{initialize(SCREEN_WIDTH, SCREEN_HEIGHT, "Rubik's Cube", 4, 5, headless)},
+	keys{},
+	WALL_COLUMNS{wallColumns(wallCubes, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT)},
+	WALL_ROWS{wallRows(wallCubes, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT)},
+	MOUSE_SENSITIVITY{6.0f},
+	camera{glm::radians(45.0f), (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT,
+		   0.1f * viewScale(cubeSize, WALL_COLUMNS, WALL_ROWS, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT),
+		   100.0f * viewScale(cubeSize, WALL_COLUMNS, WALL_ROWS, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT)},
+	cubes{}, ROTATION_SPEED_RADS{glm::radians(90.0f)},
+	moveQueues{}, solver{}, seed{std::random_device{}()}, random{seed}, SCRAMBLE_LENGTH{25},
+	shaderProgram{createCubeProgram(shaderDirectory)},
 	u_viewMatrix{(unsigned int)glGetUniformLocation(shaderProgram, "u_viewMatrix")},
+	snapshots{}, rendering{false}, SIMULATION_STEP_SECONDS{1.0f / 240.0f}, frameRequests{1}, viewChanged{false},
 	dragging{false},
-	prevTime{0}
+	deltaTime{0}, prevTime{0},
+	inputMode{INPUT_LIVE}, inputLog{}, recordPath{}, nextReplayEvent{0}, step{0}, sessionStartTime{0},
+	profiler{}, profilePath{}, profileOverlay{false}, lastOverlayTime{0}, callbackMilliseconds{0}
 {
 	glfwSetWindowUserPointer(window, this);
 	glfwSetCursorPosCallback(window, mousePositionCallbackProxy);
 	glfwSetMouseButtonCallback(window, mouseButtonCallbackProxy);
-
-	keys.setKeybind("WHITE", GLFW_KEY_W);
-	keys.setKeybind("YELLOW", GLFW_KEY_Y);
-	keys.setKeybind("RED", GLFW_KEY_R);
-	keys.setKeybind("ORANGE", GLFW_KEY_O);
-	keys.setKeybind("BLUE", GLFW_KEY_B);
-	keys.setKeybind("GREEN", GLFW_KEY_G);
-	keys.setKeybind("CLOCKWISE", GLFW_KEY_RIGHT);
-	keys.setKeybind("COUNTER_CLOCKWISE", GLFW_KEY_LEFT);
+	glfwSetKeyCallback(window, keyCallbackProxy);
+	glfwSetWindowRefreshCallback(window, windowRefreshCallbackProxy);
+
+	keys.setKeybind(ACTION_WHITE, GLFW_KEY_W);
+	keys.setKeybind(ACTION_YELLOW, GLFW_KEY_Y);
+	keys.setKeybind(ACTION_RED, GLFW_KEY_R);
+	keys.setKeybind(ACTION_ORANGE, GLFW_KEY_O);
+	keys.setKeybind(ACTION_BLUE, GLFW_KEY_B);
+	keys.setKeybind(ACTION_GREEN, GLFW_KEY_G);
+	keys.setKeybind(ACTION_CLOCKWISE, GLFW_KEY_RIGHT);
+	keys.setKeybind(ACTION_COUNTER_CLOCKWISE, GLFW_KEY_LEFT);
+	keys.setKeybind(ACTION_LAYER_IN, GLFW_KEY_UP);
+	keys.setKeybind(ACTION_LAYER_OUT, GLFW_KEY_DOWN);
+	keys.setKeybind(ACTION_SCRAMBLE, GLFW_KEY_SPACE);
+	keys.setKeybind(ACTION_SOLVE, GLFW_KEY_ENTER);
+	keys.setKeybind(ACTION_PROFILE_OVERLAY, GLFW_KEY_F3);
+
+	static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == NUM_PHASES, "A name for every phase");
+	for(const char* name : PHASE_NAMES)
+		profiler.addPhase(name);
 
 	glDebugMessageCallback(glDebugCallback, nullptr);
 	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
 	glEnable(GL_DEPTH_TEST);
 
-	camera.position = {5.0f, 5.0f, 5.0f};
+	camera.position = glm::vec3{5.0f, 5.0f, 5.0f} * viewScale(cubeSize, WALL_COLUMNS, WALL_ROWS, (float)SCREEN_WIDTH / (float)SCREEN_HEIGHT);
 	camera.rotateGlobal(camera.up(), glm::radians(45.0f));
 	camera.rotateGlobal(camera.right(), -atanf(1.0f / sqrtf(2.0f)));
 
-	glGenBuffers(1, &positionVbo);
-	glBindBuffer(GL_ARRAY_BUFFER, positionVbo);
-	glBufferData(GL_ARRAY_BUFFER, 
-				 RubiksCube::VOX_NUM_VERTS * sizeof(glm::vec3), rubiksCube.getVoxelVertexPositions(),
-				 GL_STATIC_DRAW);
+	// The wall is centered on the origin, in the plane facing the camera, so every cube is seen from the same side
+	float spacing = WALL_SPACING * RubiksCube::halfExtent(cubeSize);
+	glm::vec3 wallRight = camera.right() * spacing, wallDown = -camera.up() * spacing;
 
-	glGenBuffers(1, &colorVbo);
-	glBindBuffer(GL_ARRAY_BUFFER, colorVbo);
-	glBufferData(GL_ARRAY_BUFFER, 
-				 RubiksCube::VOX_NUM_VERTS * RubiksCube::CUBE_NUM_VOXES * sizeof(glm::vec4), rubiksCube.getColors(), 
-				 GL_STATIC_DRAW);
+	cubes.reserve(wallCubes);
+	moveQueues.reserve(wallCubes);
 
-	glGenVertexArrays(1, &vao);
-	glBindVertexArray(vao);
-	glBindVertexBuffer(0, positionVbo, 0, sizeof(glm::vec3));
+	for(int cube = 0; cube < wallCubes; cube++)
+	{
+		int column = cube % WALL_COLUMNS, row = cube / WALL_COLUMNS;
+
+		cubes.emplace_back(cubeSize);
+		cubes.back().globalTransform.position = (column - 0.5f * (WALL_COLUMNS - 1)) * wallRight +
+												(row - 0.5f * (WALL_ROWS - 1)) * wallDown;
+
+		moveQueues.emplace_back(cubes.back());
 
-	glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, 0);
-	glVertexAttribBinding(0, 0);
-	glEnableVertexAttribArray(0);
+		// Every queue fast-forwards within its share of the frame
+		moveQueues.back().setFastForwardBudget(MoveQueue::DEFAULT_FAST_FORWARD_BUDGET_SECONDS / wallCubes);
+	}
 
-	glVertexAttribFormat(1, 4, GL_FLOAT, GL_FALSE, 0);
-	glVertexAttribBinding(1, 1);
-	glEnableVertexAttribArray(1);
+	renderer = std::make_unique<CubeRenderer>(cubes.data(), cubes.size());
 
-	glGenBuffers(1, &ebo);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 
-				 RubiksCube::VOX_NUM_INDICES * sizeof(unsigned int), rubiksCube.getVoxelIndices(), 
-				 GL_STATIC_DRAW);
+	CubeRenderer::Snapshot snapshot;
+	CubeRenderer::capture(cubes.data(), cubes.size(), snapshot);
+	snapshots.fill(snapshot);
 
 	glUseProgram(shaderProgram);
 
 	glUniformMatrix4fv(glGetUniformLocation(shaderProgram, "u_projectionMatrix"),
 					   1, GL_FALSE, glm::value_ptr(camera.projectionMatrix()));
 
+	glUniform4fv(glGetUniformLocation(shaderProgram, "u_palette"),
+				 RubiksCube::NUM_COLORS, glm::value_ptr(RubiksCube::PALETTE[0]));
+
 	glm::mat4 viewMatrix = camera.viewMatrix();
 	glUniformMatrix4fv(u_viewMatrix, 1, GL_FALSE, glm::value_ptr(viewMatrix));
 }
 
 Application::~Application()
 {
-	glDeleteBuffers(1, &positionVbo);
-	glDeleteBuffers(1, &colorVbo);
-	glDeleteBuffers(1, &ebo);
-	glDeleteVertexArrays(1, &vao);
+	renderer.reset();
 	glDeleteProgram(shaderProgram);
 	glfwTerminate();
 }
 
-void Application::mouseButtonCallback(int button, int action)
+void Application::keyCallback(int key, int action)
 {
+	recordEvent(InputLog::EVENT_KEY, key, action, 0.0, 0.0);
+	keys.keyEvent(key, action);
+}
+
+void Application::mouseButtonCallback(int button, int action, double xpos, double ypos)
+{
+	recordEvent(InputLog::EVENT_MOUSE_BUTTON, button, action, xpos, ypos);
+
 	if(button == GLFW_MOUSE_BUTTON_LEFT)
 	{
 		if(action == GLFW_PRESS)
 		{
 			dragging = true;
-			glfwGetCursorPos(window, &mouseLastX, &mouseLastY);
+			mouseLastX = xpos;
+			mouseLastY = ypos;
 		}
 		else
 		{
@@ -103,6 +204,9 @@ void Application::mousePositionCallback(double xpos, double ypos)
 {
 	if(dragging)
 	{
+		// Moves only matter while dragging, so only those are recorded
+		recordEvent(InputLog::EVENT_CURSOR, 0, 0, xpos, ypos);
+
 		float mouseDX = (float)(xpos - mouseLastX);
 		float mouseDY = -(float)(ypos - mouseLastY);
 
@@ -112,87 +216,544 @@ void Application::mousePositionCallback(double xpos, double ypos)
 		glm::vec3 rotationAxis = glm::normalize(glm::cross(camera.behind(), mouseMove));
 		float angle = glm::length(mouseMove) * MOUSE_SENSITIVITY * deltaTime;
 
-		rubiksCube.globalTransform.rotation = glm::angleAxis(angle, rotationAxis) * rubiksCube.globalTransform.rotation;
+		// The cubes of a wall turn together, each about its own center
+		for(RubiksCube& cube : cubes)
+			cube.globalTransform.rotation = glm::angleAxis(angle, rotationAxis) * cube.globalTransform.rotation;
+
+		viewChanged = true;
 
 		mouseLastX = xpos;
 		mouseLastY = ypos;
 	}
 }
 
+void Application::record(const char* path)
+{
+	recordPath = path;
+	inputMode = INPUT_RECORDING;
+
+	inputLog = InputLog{};
+	inputLog.seed = seed;
+	inputLog.cubeSize = cubes.front().getSize();
+	inputLog.wallCubes = (int)cubes.size();
+	inputLog.stepSeconds = SIMULATION_STEP_SECONDS;
+
+	useFixedStep();
+}
+
+void Application::profile(const char* path)
+{
+	profilePath = path;
+}
+
+bool Application::replay(const InputLog& log)
+{
+	if((log.cubeSize != cubes.front().getSize()) || (log.wallCubes != (int)cubes.size()) || (log.stepSeconds <= 0.0f))
+	{
+		printf("The input log was recorded with --size %d --wall %d\n", log.cubeSize, log.wallCubes);
+		return false;
+	}
+
+	inputLog = log;
+	inputMode = INPUT_REPLAYING;
+	nextReplayEvent = 0;
+
+	seed = log.seed;
+	random.seed(seed);
+
+	useFixedStep();
+	return true;
+}
+
+void Application::useFixedStep()
+{
+	// Nothing may depend on how long things take : queued moves are fast-forwarded all at once and the solver is left
+	// to reach its target length
+	deltaTime = inputLog.stepSeconds;
+
+	for(MoveQueue& moveQueue : moveQueues)
+		moveQueue.setFastForwardBudget(0.0f);
+}
+
+void Application::recordEvent(InputLog::EventType type, int code, int action, double xpos, double ypos)
+{
+	if(inputMode != INPUT_RECORDING)
+		return;
+
+	inputLog.events.push_back({step, (float)(glfwGetTime() - sessionStartTime), type, (unsigned char)action, (short)code,
+							   xpos, ypos});
+}
+
+void Application::replayEvents()
+{
+	for(; nextReplayEvent < inputLog.events.size(); nextReplayEvent++)
+	{
+		const InputLog::Event& event = inputLog.events[nextReplayEvent];
+		if(event.step != step)
+			break;
+
+		switch(event.type)
+		{
+			case InputLog::EVENT_KEY :
+				keyCallback(event.code, event.action);
+				break;
+			case InputLog::EVENT_MOUSE_BUTTON :
+				mouseButtonCallback(event.code, event.action, event.x, event.y);
+				break;
+			case InputLog::EVENT_CURSOR :
+				mousePositionCallback(event.x, event.y);
+				break;
+		}
+	}
+}
+
 void Application::run()
 {
+	// The render thread has the context until the window closes
+	glfwMakeContextCurrent(nullptr);
+	rendering = true;
+	std::thread renderThread{&Application::renderLoop, this};
+
+	const bool fixedStep = inputMode != INPUT_LIVE;
+	const double stepSeconds = fixedStep ? inputLog.stepSeconds : SIMULATION_STEP_SECONDS;
+
+	sessionStartTime = glfwGetTime();
+	prevTime = sessionStartTime;
+
 	while(!glfwWindowShouldClose(window))
 	{
-		float currentTime = (float)glfwGetTime();
-		deltaTime = currentTime - prevTime;
-		prevTime = currentTime;
+		// Steps no faster than stepSeconds, but wakes up for any input
+		// While nothing moves there is nothing to step until the next input, a replay has no input to wait for
+		double waitSeconds = prevTime + stepSeconds - glfwGetTime();
+		callbackMilliseconds = 0.0;
+		if(isIdle() && (inputMode != INPUT_REPLAYING))
+		{
+			glfwWaitEvents();
 
+			// The time asleep isn't simulated
+			prevTime = std::min(prevTime, glfwGetTime() - stepSeconds);
+		}
+		else if(waitSeconds > 0.0)
+		{
+			glfwWaitEventsTimeout(waitSeconds);
+		}
+
+		// The events that ended the wait were handled inside it, only their callbacks are timed and never the sleep.
+		// Whatever came in since is polled and timed in full
+		double waitCallbackMilliseconds = callbackMilliseconds;
+		FrameProfiler::Clock::time_point phaseStart = FrameProfiler::Clock::now();
 		glfwPollEvents();
 
+		FrameProfiler::Clock::time_point polled = FrameProfiler::Clock::now();
+		profiler.record(PHASE_EVENTS, waitCallbackMilliseconds + milliseconds(polled - phaseStart));
+		phaseStart = polled;
+
+		FrameProfiler::Clock::time_point stepStart = phaseStart;
+		trace::Zone stepZone{"step"};
+
+		double currentTime = glfwGetTime();
+		deltaTime = (float)(fixedStep ? stepSeconds : currentTime - prevTime);
+		prevTime = currentTime;
+
+		if(inputMode == INPUT_REPLAYING)
+		{
+			if(step == inputLog.numSteps)
+			{
+				printf("Replayed %u steps in %.2f s\n", step, glfwGetTime() - sessionStartTime);
+				break;
+			}
+
+			replayEvents();
+		}
+
 		keys.update();
+		phaseStart = profiler.record(PHASE_KEYS, phaseStart);
+
+		// Nothing is captured or drawn unless a step changes something
+		bool changed = viewChanged;
+		viewChanged = false;
+
+		// Keys act on every cube of a wall
+		bool faceSelected = true;
+		RubiksCube::Face face = RubiksCube::FACE_POS_X;
+
+		if(keys.keyJustPressed(ACTION_WHITE))
+			face = RubiksCube::FACE_POS_Y;
+		else if(keys.keyJustPressed(ACTION_YELLOW))
+			face = RubiksCube::FACE_NEG_Y;
+		else if(keys.keyJustPressed(ACTION_RED))
+			face = RubiksCube::FACE_POS_Z;
+		else if(keys.keyJustPressed(ACTION_ORANGE))
+			face = RubiksCube::FACE_NEG_Z;
+		else if(keys.keyJustPressed(ACTION_BLUE))
+			face = RubiksCube::FACE_POS_X;
+		else if(keys.keyJustPressed(ACTION_GREEN))
+			face = RubiksCube::FACE_NEG_X;
+		else
+			faceSelected = false;
 
-		if(keys.keyJustPressed("WHITE"))
+		for(size_t cube = 0; cube < cubes.size(); cube++)
 		{
-			rubiksCube.selectedFace = RubiksCube::FACE_POS_Y;
+			RubiksCube& rubiksCube = cubes[cube];
+
+			if(faceSelected)
+			{
+				rubiksCube.selectedFace = face;
+				rubiksCube.selectedDepth = 1;
+			}
+
+			// Steps through the layers behind the selected face
+			if(keys.keyJustPressed(ACTION_LAYER_IN))
+			{
+				rubiksCube.selectedDepth = std::min(rubiksCube.selectedDepth + 1, rubiksCube.getSize());
+			}
+			else if(keys.keyJustPressed(ACTION_LAYER_OUT))
+			{
+				rubiksCube.selectedDepth = std::max(rubiksCube.selectedDepth - 1, 1);
+			}
+
+			// Queued moves own the cube until they finish
+			if(moveQueues[cube].isIdle())
+			{
+				if(keys.keyPressed(ACTION_CLOCKWISE))
+				{
+					rubiksCube.rotateFace(-ROTATION_SPEED_RADS * deltaTime);
+					changed = true;
+				}
+				else if(keys.keyPressed(ACTION_COUNTER_CLOCKWISE))
+				{
+					rubiksCube.rotateFace(ROTATION_SPEED_RADS * deltaTime);
+					changed = true;
+				}
+			}
+
+			if(keys.anyKeyJustReleased() && !rubiksCube.isSnapped())
+			{
+				rubiksCube.snapFace();
+				changed = true;
+			}
 		}
-		else if(keys.keyJustPressed("YELLOW"))
+
+		if(keys.keyJustPressed(ACTION_SCRAMBLE))
 		{
-			rubiksCube.selectedFace = RubiksCube::FACE_NEG_Y;
+			scramble();
 		}
-		else if(keys.keyJustPressed("RED"))
+		else if(keys.keyJustPressed(ACTION_SOLVE))
 		{
-			rubiksCube.selectedFace = RubiksCube::FACE_POS_Z;
+			solve();
 		}
-		else if(keys.keyJustPressed("ORANGE"))
+
+		for(MoveQueue& moveQueue : moveQueues)
 		{
-			rubiksCube.selectedFace = RubiksCube::FACE_NEG_Z;
+			changed |= !moveQueue.isIdle();
+			moveQueue.update(deltaTime);
 		}
-		else if(keys.keyJustPressed("BLUE"))
+
+		phaseStart = profiler.record(PHASE_SIMULATION, phaseStart);
+
+		if(changed)
 		{
-			rubiksCube.selectedFace = RubiksCube::FACE_POS_X;
+			trace::Zone captureZone{"capture"};
+			CubeRenderer::capture(cubes.data(), cubes.size(), snapshots.writeSlot());
+			snapshots.publish();
+			requestFrame();
+			profiler.record(PHASE_CAPTURE, phaseStart);
 		}
-		else if(keys.keyJustPressed("GREEN"))
+
+		profiler.record(PHASE_STEP, stepStart);
+
+		if(keys.keyJustPressed(ACTION_PROFILE_OVERLAY))
 		{
-			rubiksCube.selectedFace = RubiksCube::FACE_NEG_X;
+			profileOverlay = !profileOverlay;
+			if(!profileOverlay)
+				glfwSetWindowTitle(window, "Rubik's Cube");
 		}
 
-		if(keys.keyPressed("CLOCKWISE"))
+		if(profileOverlay)
+			updateProfileOverlay();
+
+		step++;
+	}
+
+	rendering = false;
+	requestFrame();
+	renderThread.join();
+	glfwMakeContextCurrent(window);
+
+	if(inputMode == INPUT_RECORDING)
+	{
+		inputLog.numSteps = step;
+		if(inputLog.save(recordPath.c_str()))
+			printf("Recorded %u steps and %zu events into %s\n", step, inputLog.events.size(), recordPath.c_str());
+	}
+
+	if(!profilePath.empty() && profiler.save(profilePath.c_str()))
+		printf("Wrote the frame profile to %s\n", profilePath.c_str());
+}
+
+void Application::updateProfileOverlay()
+{
+	// The tree has no text rendering, the window title serves as the overlay
+	double time = glfwGetTime();
+	if(time - lastOverlayTime < PROFILE_OVERLAY_SECONDS)
+		return;
+
+	lastOverlayTime = time;
+
+	FrameProfiler::Summary stepTimes = profiler.recent(PHASE_STEP);
+	FrameProfiler::Summary frameTimes = profiler.recent(PHASE_FRAME);
+	FrameProfiler::Summary gpuTimes = profiler.recent(PHASE_GPU);
+
+	char title[256];
+	snprintf(title, sizeof(title),
+			 "Rubik's Cube | ms p50/p95/p99/max | step %.2f/%.2f/%.2f/%.2f | frame %.2f/%.2f/%.2f/%.2f | gpu %.2f/%.2f/%.2f/%.2f",
+			 stepTimes.p50, stepTimes.p95, stepTimes.p99, stepTimes.max,
+			 frameTimes.p50, frameTimes.p95, frameTimes.p99, frameTimes.max,
+			 gpuTimes.p50, gpuTimes.p95, gpuTimes.p99, gpuTimes.max);
+
+	glfwSetWindowTitle(window, title);
+}
+
+bool Application::isIdle() const
+{
+	if(keys.keyPressed(ACTION_CLOCKWISE) || keys.keyPressed(ACTION_COUNTER_CLOCKWISE))
+		return false;
+
+	for(size_t cube = 0; cube < cubes.size(); cube++)
+	{
+		if(!moveQueues[cube].isIdle() || !cubes[cube].isSnapped())
+			return false;
+	}
+
+	return true;
+}
+
+void Application::requestFrame()
+{
+	frameRequests.fetch_add(1);
+	frameRequests.notify_one();
+}
+
+void Application::renderLoop()
+{
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(1);
+	trace::setThreadName("render");
+
+	unsigned int gpuQueries[NUM_GPU_QUERIES];
+	bool gpuQueryPending[NUM_GPU_QUERIES] = {};
+	glGenQueries(NUM_GPU_QUERIES, gpuQueries);
+	int gpuQuery = 0;
+
+	// Presents at the display's rate, whatever the simulation is busy with, and sleeps until the next request
+	unsigned int drawnRequests = 0;
+	while(true)
+	{
+		unsigned int requests = frameRequests.load();
+		if(requests == drawnRequests)
 		{
-			rubiksCube.rotateFace(-ROTATION_SPEED_RADS * deltaTime);
+			frameRequests.wait(requests);
+			continue;
 		}
-		else if(keys.keyPressed("COUNTER_CLOCKWISE"))
+
+		if(!rendering)
+			break;
+
+		drawnRequests = requests;
+		trace::Zone frameZone{"frame"};
+
+		// The oldest query is reused, its result dropped rather than waited for if the GPU is that far behind
+		unsigned int query = gpuQueries[gpuQuery];
+		if(gpuQueryPending[gpuQuery])
 		{
-			rubiksCube.rotateFace(ROTATION_SPEED_RADS * deltaTime);
+			int available = GL_FALSE;
+			glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+			if(available)
+			{
+				GLuint64 nanoseconds;
+				glGetQueryObjectui64v(query, GL_QUERY_RESULT, &nanoseconds);
+				profiler.record(PHASE_GPU, nanoseconds / 1e6);
+			}
 		}
 
-		if(keys.anyKeyJustReleased())
+		FrameProfiler::Clock::time_point frameStart = FrameProfiler::Clock::now();
+
 		{
-			rubiksCube.snapFace();
+			trace::Zone drawZone{"draw"};
+			glBeginQuery(GL_TIME_ELAPSED, query);
+			draw(snapshots.read());
+			glEndQuery(GL_TIME_ELAPSED);
 		}
 
-		glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		gpuQueryPending[gpuQuery] = true;
+		gpuQuery = (gpuQuery + 1) % NUM_GPU_QUERIES;
 
-		for(size_t voxel = 0; voxel < RubiksCube::CUBE_NUM_VOXES; voxel++)
+		FrameProfiler::Clock::time_point phaseStart = profiler.record(PHASE_DRAW, frameStart);
 		{
-			glBindVertexBuffer(1, colorVbo, voxel * RubiksCube::VOX_NUM_VERTS * sizeof(glm::vec4), sizeof(glm::vec4));
+			trace::Zone swapZone{"swap"};
+			glfwSwapBuffers(window);
+		}
+		profiler.record(PHASE_SWAP, phaseStart);
+		profiler.record(PHASE_FRAME, frameStart);
+	}
+
+	glDeleteQueries(NUM_GPU_QUERIES, gpuQueries);
+	glfwMakeContextCurrent(nullptr);
+}
+
+void Application::draw(const CubeRenderer::Snapshot& snapshot)
+{
+	glClearColor(0.12f, 0.12f, 0.12f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	renderer->draw(snapshot);
+}
+
+bool Application::renderScrambles(const char* scramblesPath, const char* outputDirectory)
+{
+	std::ifstream file{scramblesPath};
+	if(!file.is_open())
+	{
+		printf("Failed to open %s\n", scramblesPath);
+		return false;
+	}
+
+	FrameCapture capture{SCREEN_WIDTH, SCREEN_HEIGHT};
+	capture.bind();
+
+	bool success = true;
+	int numImages = 0;
+	double startTime = glfwGetTime();
 
-			glm::mat4 modelMatrix = rubiksCube.globalTransform.matrix() * rubiksCube.getTransforms()[voxel].matrix();
-			glUniformMatrix4fv(u_modelMatrix, 1, GL_FALSE, glm::value_ptr(modelMatrix));
+	std::string line;
+	std::vector<LayerMove> moves;
+	char path[4096];
 
-			glDrawElements(GL_TRIANGLES, RubiksCube::VOX_NUM_INDICES, GL_UNSIGNED_INT, (const void*)0);
+	for(int lineNumber = 0; std::getline(file, line); lineNumber++)
+	{
+		size_t errorOffset;
+		if(!notation::parse(line.data(), line.size(), moves, &errorOffset))
+		{
+			printf("%s:%d : unknown move at column %zu, skipped\n", scramblesPath, lineNumber + 1, errorOffset + 1);
+			success = false;
+			continue;
 		}
 
-		glfwSwapBuffers(window);
+		trace::Zone imageZone{"render scramble"};
+
+		cubes.front().reset();
+		cubes.front().applyMoves(moves);
+
+		// No render thread here, the snapshot is drawn right away
+		CubeRenderer::capture(cubes.data(), cubes.size(), snapshots.writeSlot());
+		draw(snapshots.writeSlot());
+
+		snprintf(path, sizeof(path), "%s/%06d.ppm", outputDirectory, lineNumber);
+		success &= capture.capture(path);
+		numImages++;
+	}
+
+	success &= capture.finish();
+
+	double seconds = glfwGetTime() - startTime;
+	printf("Rendered %d images in %.2f s (%.1f images/s)\n", numImages, seconds, numImages / (seconds > 0.0 ? seconds : 1.0));
+
+	return success;
+}
+
+void Application::scramble(MoveQueue& moveQueue, int size)
+{
+	// Bigger cubes also turn the layers up to halfway in from each face, and need more moves to mix them
+	int scrambleLength = SCRAMBLE_LENGTH * std::max(1, size - 2);
+
+	std::uniform_int_distribution<int> moveDistribution{0, NUM_FACE_MOVES - 1};
+	std::uniform_int_distribution<int> depthDistribution{1, std::max(1, size / 2)};
+
+	int lastFace = NO_FACE;
+	for(int i = 0; i < scrambleLength; i++)
+	{
+		Move move;
+		do
+			move = (Move)moveDistribution(random);
+		while(isRedundantMove(moveFace(move), lastFace));
+
+		int depth = depthDistribution(random);
+		moveQueue.push(LayerMove{move, (unsigned char)((depth == 1) ? 0 : depth)});
+		lastFace = moveFace(move);
+	}
+}
+
+void Application::scramble()
+{
+	// Each cube of a wall gets its own scramble
+	for(size_t cube = 0; cube < cubes.size(); cube++)
+		scramble(moveQueues[cube], cubes[cube].getSize());
+}
+
+void Application::solve()
+{
+	// It only knows the 3x3x3
+	if(cubes.front().getSize() != 3)
+		return;
+
+	if(!solver.isReady())
+		solver.loadTables("two_phase_solver.tables");
+
+	// Not cut short by the clock on a fixed step, so a replay finds the same solutions as its recording
+	float solveTimeLimit = (inputMode == INPUT_LIVE) ? TwoPhaseSolver::DEFAULT_TIME_LIMIT_SECONDS : FIXED_STEP_SOLVE_SECONDS;
+
+	MoveSequence solution;
+	for(size_t cube = 0; cube < cubes.size(); cube++)
+	{
+		// The solver works from the logical state, which only matches the screen once everything queued has played
+		if(!moveQueues[cube].isIdle() || !cubes[cube].isSnapped())
+			continue;
+
+		if(solver.solve(cubes[cube].getState(), solution, TwoPhaseSolver::DEFAULT_TARGET_LENGTH, solveTimeLimit))
+			moveQueues[cube].push(solution);
 	}
 }
 
+// A replay only takes its input from the log
+
 void Application::mousePositionCallbackProxy(GLFWwindow* window, double xpos, double ypos)
 {
-	((Application*)glfwGetWindowUserPointer(window))->mousePositionCallback(xpos, ypos);
+	Application* application = (Application*)glfwGetWindowUserPointer(window);
+	if(application->inputMode != INPUT_REPLAYING)
+	{
+		FrameProfiler::Clock::time_point start = FrameProfiler::Clock::now();
+		application->mousePositionCallback(xpos, ypos);
+		application->callbackMilliseconds += milliseconds(FrameProfiler::Clock::now() - start);
+	}
 }
 
 void Application::mouseButtonCallbackProxy(GLFWwindow* window, int button, int action, int mods)
 {
-	((Application*)glfwGetWindowUserPointer(window))->mouseButtonCallback(button, action);
+	Application* application = (Application*)glfwGetWindowUserPointer(window);
+	if(application->inputMode != INPUT_REPLAYING)
+	{
+		FrameProfiler::Clock::time_point start = FrameProfiler::Clock::now();
+
+		double xpos, ypos;
+		glfwGetCursorPos(window, &xpos, &ypos);
+		application->mouseButtonCallback(button, action, xpos, ypos);
+		application->callbackMilliseconds += milliseconds(FrameProfiler::Clock::now() - start);
+	}
+}
+
+void Application::keyCallbackProxy(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	Application* application = (Application*)glfwGetWindowUserPointer(window);
+	if(application->inputMode != INPUT_REPLAYING)
+	{
+		FrameProfiler::Clock::time_point start = FrameProfiler::Clock::now();
+		application->keyCallback(key, action);
+		application->callbackMilliseconds += milliseconds(FrameProfiler::Clock::now() - start);
+	}
+}
+
+void Application::windowRefreshCallbackProxy(GLFWwindow* window)
+{
+	// The window was uncovered or resized, the last snapshot is drawn again
+	((Application*)glfwGetWindowUserPointer(window))->requestFrame();
 }
\ No newline at end of file
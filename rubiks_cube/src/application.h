@@ -5,6 +5,18 @@
 #include "camera.h"
 #include "rubiks_cube.h"
 #include "keyboard_input.h"
+#include "move_queue.h"
+#include "two_phase_solver.h"
+#include "cube_renderer.h"
+#include "triple_buffer.h"
+#include "input_log.h"
+#include "frame_profiler.h"
+
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
 
 class Application 
 {
@@ -12,35 +24,166 @@ private :
 
 	const int SCREEN_WIDTH, SCREEN_HEIGHT;
 	GLFWwindow* window;
+
+	// What the keys are bound to
+	enum Action
+	{
+		ACTION_WHITE,
+		ACTION_YELLOW,
+		ACTION_RED,
+		ACTION_ORANGE,
+		ACTION_BLUE,
+		ACTION_GREEN,
+		ACTION_CLOCKWISE,
+		ACTION_COUNTER_CLOCKWISE,
+		ACTION_LAYER_IN,
+		ACTION_LAYER_OUT,
+		ACTION_SCRAMBLE,
+		ACTION_SOLVE,
+		ACTION_PROFILE_OVERLAY,
+		NUM_ACTIONS
+	};
+
+	static_assert(NUM_ACTIONS <= KeyboardInput::MAX_ACTIONS, "Too many actions for KeyboardInput");
+
 	KeyboardInput keys;
 
+	// Cubes are laid out in a grid facing the camera, a single cube is a wall of one
+	const int WALL_COLUMNS, WALL_ROWS;
+
 	const float MOUSE_SENSITIVITY;
 	Camera camera;
 
-	RubiksCube rubiksCube;
+	// Reserved up front and never grown, the move queues and the renderer point into it
+	std::vector<RubiksCube> cubes;
 	const float ROTATION_SPEED_RADS;
 
-	unsigned int positionVbo, colorVbo, ebo, vao;
+	std::vector<MoveQueue> moveQueues;
+	TwoPhaseSolver solver;
+	unsigned int seed;
+	std::mt19937 random;
+	const int SCRAMBLE_LENGTH;
+
 	unsigned int shaderProgram;
-	unsigned int u_modelMatrix;
 	unsigned int u_viewMatrix;
 
+	// Owned through a pointer so it is deleted before the context, which goes with the window in the destructor
+	std::unique_ptr<CubeRenderer> renderer;
+
+	// While the window is open the cubes are simulated on the main thread, which also handles the window's events, and
+	// drawn on a render thread that owns the context. The simulation publishes a snapshot of them every step, the
+	// render thread draws the latest one, neither ever waits on the other
+	TripleBuffer<CubeRenderer::Snapshot> snapshots;
+	std::atomic<bool> rendering;
+	const float SIMULATION_STEP_SECONDS;
+
+	// Frames are only drawn on request : when a step changed something or the window needs redrawing.
+	// The simulation itself sleeps while idle, so a still cube costs neither CPU nor GPU time
+	std::atomic<unsigned int> frameRequests;
+	bool viewChanged;
+
 	bool dragging;
 	double mouseLastX, mouseLastY;
 
-	float deltaTime, prevTime;
+	float deltaTime;
+	double prevTime;
+
+	// Recording and replaying run on a fixed step instead of following the clock, so a replay plays out exactly as the
+	// session it was recorded from
+	enum InputMode
+	{
+		INPUT_LIVE,
+		INPUT_RECORDING,
+		INPUT_REPLAYING
+	};
+
+	InputMode inputMode;
+	InputLog inputLog;
+	std::string recordPath;
+	size_t nextReplayEvent;
+	unsigned int step;
+	double sessionStartTime;
+
+	// Every phase of a step and of a frame is timed, the GPU's share of a frame through timer queries read a few frames
+	// later so they never stall it. The overlay shows recent percentiles in the window title
+	enum Phase
+	{
+		PHASE_EVENTS,
+		PHASE_KEYS,
+		PHASE_SIMULATION,
+		PHASE_CAPTURE,
+		PHASE_STEP,
+		PHASE_DRAW,
+		PHASE_SWAP,
+		PHASE_FRAME,
+		PHASE_GPU,
+		NUM_PHASES
+	};
+
+	FrameProfiler profiler;
+	std::string profilePath;
+	bool profileOverlay;
+	double lastOverlayTime;
+
+	// Time spent in the input callbacks, which the waits run without telling how long they slept
+	double callbackMilliseconds;
 
 	static void mousePositionCallbackProxy(GLFWwindow* window, double xpos, double ypos);
 	static void mouseButtonCallbackProxy(GLFWwindow* window, int button, int action, int mods);
+	static void keyCallbackProxy(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void windowRefreshCallbackProxy(GLFWwindow* window);
 
-	void mouseButtonCallback(int button, int action);
+	void keyCallback(int key, int action);
+	void mouseButtonCallback(int button, int action, double xpos, double ypos);
 	void mousePositionCallback(double xpos, double ypos);
 
+	void recordEvent(InputLog::EventType type, int code, int action, double xpos, double ypos);
+	void replayEvents();
+	void useFixedStep();
+
+	void scramble(MoveQueue& moveQueue, int size);
+	void scramble();
+	void solve();
+
+	// Nothing moving and no key turning a layer, so a step would change nothing
+	bool isIdle() const;
+
+	void updateProfileOverlay();
+
+	void requestFrame();
+	void renderLoop();
+	void draw(const CubeRenderer::Snapshot& snapshot);
+
 public :
-	Application();
+	// Bounds on the cubes of a wall, which are all kept and streamed every frame
+	static constexpr int
+		MAX_WALL_CUBES = 4096,
+		MAX_WALL_CUBIES = 1 << 20;
+
+	// Shaders are built into the executable, a shaderDirectory holding vertex_shader.shader and fragment_shader.shader
+	// replaces them
+	Application(int screenWidth = 1280, int screenHeight = 720, bool headless = false,
+				int cubeSize = RubiksCube::DEFAULT_SIZE, int wallCubes = 1, const char* shaderDirectory = nullptr);
 	~Application();
 
 	void run();
+
+	// Before run(), writes the session's input to path once the window closes
+	void record(const char* path);
+
+	// Before run(), writes every phase's timings over the session to path once the window closes, as JSON if it ends
+	// in .json and as CSV otherwise
+	void profile(const char* path);
+
+	// Before run(), plays the log's input instead of the window's and closes the window once it is over.
+	// Fails unless the log was recorded with the same cube size and wall
+	bool replay(const InputLog& log);
+
+	/*
+		Renders one image per line of the scrambles file, each scramble applied to a solved cube, without showing the window.
+		Images are written to outputDirectory as binary PPMs named after the line number (000000.ppm, ...).
+	*/
+	bool renderScrambles(const char* scramblesPath, const char* outputDirectory);
 };
 
 #endif
\ No newline at end of file
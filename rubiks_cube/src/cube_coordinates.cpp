@@ -0,0 +1,195 @@
+#include "cube_coordinates.h"
+
+namespace
+{
+	constexpr int NUM_SLICE_EDGES = CubeState::NUM_EDGES - coordinates::SLICE_EDGE;
+
+	constexpr int binomial(int n, int k)
+	{
+		if((k < 0) || (k > n))
+			return 0;
+
+		int result = 1;
+		for(int i = 1; i <= k; i++)
+			result = result * (n - k + i) / i;
+		return result;
+	}
+}
+
+int coordinates::permutationRank(const unsigned char* permutation, int size)
+{
+	int rank = 0;
+	for(int i = 0; i < size; i++)
+	{
+		int smallerAfter = 0;
+		for(int j = i + 1; j < size; j++)
+		{
+			if(permutation[j] < permutation[i])
+				smallerAfter++;
+		}
+		rank = rank * (size - i) + smallerAfter;
+	}
+	return rank;
+}
+
+void coordinates::setPermutationRank(unsigned char* permutation, int size, int rank)
+{
+	int digits[CubeState::NUM_EDGES];
+	for(int i = size - 1; i >= 0; i--)
+	{
+		digits[i] = rank % (size - i);
+		rank /= (size - i);
+	}
+
+	unsigned char remaining[CubeState::NUM_EDGES];
+	for(int i = 0; i < size; i++)
+		remaining[i] = (unsigned char)i;
+
+	int numRemaining = size;
+	for(int i = 0; i < size; i++)
+	{
+		permutation[i] = remaining[digits[i]];
+		for(int j = digits[i]; j < numRemaining - 1; j++)
+			remaining[j] = remaining[j + 1];
+		numRemaining--;
+	}
+}
+
+int coordinates::twist(const CubeState& state)
+{
+	int twist = 0;
+	for(int i = 0; i < CubeState::NUM_CORNERS - 1; i++)
+		twist = twist * 3 + state.cornerOrientation[i];
+	return twist;
+}
+
+void coordinates::setTwist(CubeState& state, int twist)
+{
+	int sum = 0;
+	for(int i = CubeState::NUM_CORNERS - 2; i >= 0; i--)
+	{
+		state.cornerOrientation[i] = (unsigned char)(twist % 3);
+		sum += twist % 3;
+		twist /= 3;
+	}
+	state.cornerOrientation[CubeState::NUM_CORNERS - 1] = (unsigned char)((3 - sum % 3) % 3);
+}
+
+int coordinates::flip(const CubeState& state)
+{
+	int flip = 0;
+	for(int i = 0; i < CubeState::NUM_EDGES - 1; i++)
+		flip = flip * 2 + state.edgeOrientation[i];
+	return flip;
+}
+
+void coordinates::setFlip(CubeState& state, int flip)
+{
+	int sum = 0;
+	for(int i = CubeState::NUM_EDGES - 2; i >= 0; i--)
+	{
+		state.edgeOrientation[i] = (unsigned char)(flip % 2);
+		sum += flip % 2;
+		flip /= 2;
+	}
+	state.edgeOrientation[CubeState::NUM_EDGES - 1] = (unsigned char)(sum % 2);
+}
+
+int coordinates::slice(const CubeState& state)
+{
+	// Combinatorial number system over positions counted from the back, so the solved slice is 0
+	int slice = 0, found = 0;
+	for(int position = CubeState::NUM_EDGES - 1; position >= 0; position--)
+	{
+		if(state.edgePermutation[position] >= SLICE_EDGE)
+		{
+			found++;
+			slice += binomial(CubeState::NUM_EDGES - 1 - position, found);
+		}
+	}
+	return slice;
+}
+
+void coordinates::setSlice(CubeState& state, int slice)
+{
+	bool isSlicePosition[CubeState::NUM_EDGES]{};
+
+	for(int k = NUM_SLICE_EDGES; k > 0; k--)
+	{
+		int reversedPosition = k - 1;
+		while(binomial(reversedPosition + 1, k) <= slice)
+			reversedPosition++;
+
+		slice -= binomial(reversedPosition, k);
+		isSlicePosition[CubeState::NUM_EDGES - 1 - reversedPosition] = true;
+	}
+
+	unsigned char nextSliceEdge = SLICE_EDGE, nextOtherEdge = 0;
+	for(int position = 0; position < CubeState::NUM_EDGES; position++)
+		state.edgePermutation[position] = isSlicePosition[position] ? nextSliceEdge++ : nextOtherEdge++;
+}
+
+int coordinates::cornerPermutation(const CubeState& state)
+{
+	return permutationRank(state.cornerPermutation, CubeState::NUM_CORNERS);
+}
+
+void coordinates::setCornerPermutation(CubeState& state, int cornerPermutation)
+{
+	setPermutationRank(state.cornerPermutation, CubeState::NUM_CORNERS, cornerPermutation);
+}
+
+int coordinates::edgePermutation(const CubeState& state)
+{
+	return permutationRank(state.edgePermutation, SLICE_EDGE);
+}
+
+void coordinates::setEdgePermutation(CubeState& state, int edgePermutation)
+{
+	setPermutationRank(state.edgePermutation, SLICE_EDGE, edgePermutation);
+}
+
+int coordinates::slicePermutation(const CubeState& state)
+{
+	unsigned char permutation[NUM_SLICE_EDGES];
+	for(int i = 0; i < NUM_SLICE_EDGES; i++)
+		permutation[i] = (unsigned char)(state.edgePermutation[SLICE_EDGE + i] - SLICE_EDGE);
+	return permutationRank(permutation, NUM_SLICE_EDGES);
+}
+
+void coordinates::setSlicePermutation(CubeState& state, int slicePermutation)
+{
+	unsigned char permutation[NUM_SLICE_EDGES];
+	setPermutationRank(permutation, NUM_SLICE_EDGES, slicePermutation);
+	for(int i = 0; i < NUM_SLICE_EDGES; i++)
+		state.edgePermutation[SLICE_EDGE + i] = (unsigned char)(permutation[i] + SLICE_EDGE);
+}
+
+unsigned int coordinates::fingerprint()
+{
+	// FNV-1a
+	unsigned int hash = 2166136261u;
+	auto add = [&hash](const unsigned char* bytes, size_t size)
+	{
+		for(size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 16777619u;
+	};
+
+	// Every face move, each after the ones before it so the coordinates get away from solved
+	CubeState state;
+	for(int move = 0; move < NUM_FACE_MOVES; move++)
+	{
+		state.applyMove((Move)move);
+
+		add(state.cornerPermutation, CubeState::NUM_CORNERS);
+		add(state.cornerOrientation, CubeState::NUM_CORNERS);
+		add(state.edgePermutation, CubeState::NUM_EDGES);
+		add(state.edgeOrientation, CubeState::NUM_EDGES);
+
+		int values[6] = {twist(state), flip(state), slice(state),
+						 cornerPermutation(state), edgePermutation(state), slicePermutation(state)};
+		add((const unsigned char*)values, sizeof(values));
+	}
+
+	return hash;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef CUBE_COORDINATES_H
+#define CUBE_COORDINATES_H
+
+#include "cube_state.h"
+
+// Dense integer coordinates of (parts of) a CubeState, each solved state maps to 0
+namespace coordinates
+{
+	inline constexpr int
+		NUM_TWISTS = 2187,
+		NUM_FLIPS = 2048,
+		NUM_SLICES = 495,
+		NUM_CORNER_PERMUTATIONS = 40320,
+		NUM_EDGE_PERMUTATIONS = 40320,
+		NUM_SLICE_PERMUTATIONS = 24;
+
+	// First UD-slice edge (FR), the slice edges are the last four
+	inline constexpr int SLICE_EDGE = 8;
+
+	int permutationRank(const unsigned char* permutation, int size);
+	void setPermutationRank(unsigned char* permutation, int size, int rank);
+
+	int twist(const CubeState& state);
+	void setTwist(CubeState& state, int twist);
+
+	int flip(const CubeState& state);
+	void setFlip(CubeState& state, int flip);
+
+	// Positions of the four UD-slice edges, ignoring their order
+	int slice(const CubeState& state);
+	void setSlice(CubeState& state, int slice);
+
+	int cornerPermutation(const CubeState& state);
+	void setCornerPermutation(CubeState& state, int cornerPermutation);
+
+	// Permutation of the eight U/D-layer edges, only meaningful while the slice edges are in the slice
+	int edgePermutation(const CubeState& state);
+	void setEdgePermutation(CubeState& state, int edgePermutation);
+
+	int slicePermutation(const CubeState& state);
+	void setSlicePermutation(CubeState& state, int slicePermutation);
+
+	// Hash of the cubies and every coordinate after each face move, which changes with the numbering of the moves,
+	// cubies or any coordinate. Tables built from them keep it to tell tables generated by another build apart
+	unsigned int fingerprint();
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "cube_renderer.h"
+
+#include <stddef.h>
+#include <cstring>
+
+void CubeRenderer::capture(const RubiksCube* cubes, size_t numCubes, Snapshot& snapshot)
+{
+	const size_t transformsPerCube = cubes[0].getNumTransforms();
+
+	// A new snapshot has none of the bodies
+	bool empty = snapshot.meshRevisions.size() != numCubes;
+	if(empty)
+	{
+		snapshot.transforms.resize(numCubes * transformsPerCube);
+		snapshot.bodies.resize(numCubes * BODY_NUM_VERTS);
+		snapshot.bodyNumIndices.resize(numCubes);
+		snapshot.meshRevisions.resize(numCubes);
+	}
+
+	const size_t stickerNumIndices = cubes[0].getNumMeshIndices() - RubiksCube::MAX_BODY_BOXES * RubiksCube::BOX_NUM_INDICES;
+
+	for(size_t cube = 0; cube < numCubes; cube++)
+	{
+		const RubiksCube& rubiksCube = cubes[cube];
+
+		// Only the body changes, when a different layer starts or stops turning
+		if(empty || (rubiksCube.getMeshRevision() != snapshot.meshRevisions[cube]))
+		{
+			std::memcpy(snapshot.bodies.data() + cube * BODY_NUM_VERTS, rubiksCube.getVertices() + rubiksCube.getBodyFirstVertex(),
+						BODY_NUM_VERTS * sizeof(RubiksCube::Vertex));
+			snapshot.bodyNumIndices[cube] = (unsigned int)(rubiksCube.getNumIndices() - stickerNumIndices);
+			snapshot.meshRevisions[cube] = rubiksCube.getMeshRevision();
+		}
+
+		// Neither the cube nor its cubies are ever scaled, so a rotation and a position are all the shader needs
+		const Transform& global = rubiksCube.globalTransform;
+		const Transform* transforms = rubiksCube.getTransforms();
+		TransformInstance* cubeInstances = snapshot.transforms.data() + cube * transformsPerCube;
+
+		for(size_t transform = 0; transform < transformsPerCube; transform++)
+		{
+			glm::quat rotation = global.rotation * transforms[transform].rotation;
+			glm::vec3 position = global.rotation * transforms[transform].position + global.position;
+
+			cubeInstances[transform].rotation = glm::vec4{rotation.x, rotation.y, rotation.z, rotation.w};
+			cubeInstances[transform].position = glm::vec4{position, 1.0f};
+		}
+	}
+}
+
+CubeRenderer::CubeRenderer(const RubiksCube* cubes, size_t numCubes) :
+	numCubes{numCubes},
+	transformsPerCube{cubes[0].getNumTransforms()},
+	stickerNumVerts{cubes[0].getBodyFirstVertex()},
+	stickerNumIndices{cubes[0].getNumMeshIndices() - RubiksCube::MAX_BODY_BOXES * RubiksCube::BOX_NUM_INDICES},
+	instances{0, numCubes * transformsPerCube * sizeof(TransformInstance)},
+	commands(2 * numCubes), uploadedMeshRevisions(numCubes)
+{
+	// The stickers, then every cube's body. The body indices count from the first cube's body
+	glGenBuffers(1, &vbo);
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferData(GL_ARRAY_BUFFER, (stickerNumVerts + numCubes * BODY_NUM_VERTS) * sizeof(RubiksCube::Vertex), nullptr,
+				 GL_DYNAMIC_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, stickerNumVerts * sizeof(RubiksCube::Vertex), cubes[0].getVertices());
+
+	for(size_t cube = 0; cube < numCubes; cube++)
+		uploadBody(cube, cubes[cube].getVertices() + cubes[cube].getBodyFirstVertex(), cubes[cube].getMeshRevision());
+
+	// Where each cube's transforms start, read once per draw command through its base instance
+	std::vector<unsigned int> firstTransforms(numCubes);
+	for(size_t cube = 0; cube < numCubes; cube++)
+		firstTransforms[cube] = (unsigned int)(cube * transformsPerCube);
+
+	glGenBuffers(1, &firstTransformsBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, firstTransformsBuffer);
+	glBufferData(GL_ARRAY_BUFFER, numCubes * sizeof(unsigned int), firstTransforms.data(), GL_STATIC_DRAW);
+
+	glGenVertexArrays(1, &vao);
+	glBindVertexArray(vao);
+	glBindVertexBuffer(0, vbo, 0, sizeof(RubiksCube::Vertex));
+	glBindVertexBuffer(1, firstTransformsBuffer, 0, sizeof(unsigned int));
+	glVertexBindingDivisor(1, 1);
+
+	glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(RubiksCube::Vertex, position));
+	glVertexAttribBinding(0, 0);
+	glEnableVertexAttribArray(0);
+
+	glVertexAttribIFormat(1, 1, GL_UNSIGNED_INT, offsetof(RubiksCube::Vertex, transform));
+	glVertexAttribBinding(1, 0);
+	glEnableVertexAttribArray(1);
+
+	glVertexAttribIFormat(2, 1, GL_UNSIGNED_BYTE, offsetof(RubiksCube::Vertex, color));
+	glVertexAttribBinding(2, 0);
+	glEnableVertexAttribArray(2);
+
+	glVertexAttribIFormat(3, 1, GL_UNSIGNED_INT, 0);
+	glVertexAttribBinding(3, 1);
+	glEnableVertexAttribArray(3);
+
+	glGenBuffers(1, &ebo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+				 cubes[0].getNumMeshIndices() * sizeof(unsigned int), cubes[0].getIndices(),
+				 GL_STATIC_DRAW);
+
+	for(size_t cube = 0; cube < numCubes; cube++)
+	{
+		commands[2 * cube] = {(unsigned int)stickerNumIndices, 1, 0, 0, (unsigned int)cube};
+		commands[2 * cube + 1] = {(unsigned int)(cubes[cube].getNumIndices() - stickerNumIndices), 1,
+								  (unsigned int)stickerNumIndices, (int)(cube * BODY_NUM_VERTS), (unsigned int)cube};
+	}
+
+	glGenBuffers(1, &indirectBuffer);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawCommand), commands.data(), GL_DYNAMIC_DRAW);
+}
+
+CubeRenderer::~CubeRenderer()
+{
+	glDeleteBuffers(1, &vbo);
+	glDeleteBuffers(1, &ebo);
+	glDeleteBuffers(1, &firstTransformsBuffer);
+	glDeleteBuffers(1, &indirectBuffer);
+	glDeleteVertexArrays(1, &vao);
+}
+
+void CubeRenderer::uploadBody(size_t cube, const RubiksCube::Vertex* vertices, unsigned int meshRevision)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, vbo);
+	glBufferSubData(GL_ARRAY_BUFFER, (stickerNumVerts + cube * BODY_NUM_VERTS) * sizeof(RubiksCube::Vertex),
+					BODY_NUM_VERTS * sizeof(RubiksCube::Vertex), vertices);
+	uploadedMeshRevisions[cube] = meshRevision;
+}
+
+void CubeRenderer::draw(const Snapshot& snapshot)
+{
+	bool commandsOutdated = false;
+
+	for(size_t cube = 0; cube < numCubes; cube++)
+	{
+		if(snapshot.meshRevisions[cube] != uploadedMeshRevisions[cube])
+		{
+			uploadBody(cube, snapshot.bodies.data() + cube * BODY_NUM_VERTS, snapshot.meshRevisions[cube]);
+			commands[2 * cube + 1].count = snapshot.bodyNumIndices[cube];
+			commandsOutdated = true;
+		}
+	}
+
+	// Written straight into the mapped buffer
+	std::memcpy(instances.beginWrite(), snapshot.transforms.data(), snapshot.transforms.size() * sizeof(TransformInstance));
+	instances.endWrite();
+
+	glBindVertexArray(vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+
+	if(commandsOutdated)
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, commands.size() * sizeof(DrawCommand), commands.data());
+
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*)0, (GLsizei)commands.size(), 0);
+	instances.fence();
+}
\ No newline at end of file
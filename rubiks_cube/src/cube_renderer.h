@@ -0,0 +1,73 @@
+#ifndef CUBE_RENDERER_H
+#define CUBE_RENDERER_H
+
+#include "util.h"
+#include "rubiks_cube.h"
+#include "stream_buffer.h"
+
+#include <vector>
+
+/*
+	Draws any number of cubes of one size with a single glMultiDrawElementsIndirect.
+	The stickers are the same for every cube and stored once, a cube only has its own body vertices and transforms.
+	Each cube gets two draw commands, its stickers and its body, whose base instance picks its transforms through
+	an instanced attribute.
+	The cubes are drawn from a Snapshot of them, so they can go on changing on another thread while it is drawn.
+*/
+class CubeRenderer
+{
+public :
+	// Transform as read by the vertex shader, the cube's own transform already applied
+	struct TransformInstance
+	{
+		glm::vec4 rotation; // quaternion, xyzw
+		glm::vec4 position; // w unused
+	};
+
+	static_assert(sizeof(TransformInstance) == 32, "TransformInstance must match the std430 layout in vertex_shader.shader");
+
+	static constexpr int BODY_NUM_VERTS = RubiksCube::MAX_BODY_BOXES * RubiksCube::BOX_NUM_VERTS;
+
+	// Everything drawn of the cubes at one point in time
+	struct Snapshot
+	{
+		std::vector<TransformInstance> transforms; // getNumTransforms() per cube
+		std::vector<RubiksCube::Vertex> bodies; // BODY_NUM_VERTS per cube
+		std::vector<unsigned int> bodyNumIndices;
+		std::vector<unsigned int> meshRevisions;
+	};
+
+	// Only copies the bodies that changed since the snapshot was last taken
+	static void capture(const RubiksCube* cubes, size_t numCubes, Snapshot& snapshot);
+
+	// The cubes all have the same size, they are only read here
+	CubeRenderer(const RubiksCube* cubes, size_t numCubes);
+	~CubeRenderer();
+
+	// With the program using vertex_shader.shader bound
+	void draw(const Snapshot& snapshot);
+
+private :
+	// As read by glMultiDrawElementsIndirect
+	struct DrawCommand
+	{
+		unsigned int count;
+		unsigned int instanceCount;
+		unsigned int firstIndex;
+		int baseVertex;
+		unsigned int baseInstance;
+	};
+
+	const size_t numCubes;
+	const size_t transformsPerCube, stickerNumVerts, stickerNumIndices;
+
+	unsigned int vbo, ebo, firstTransformsBuffer, indirectBuffer, vao;
+	StreamBuffer instances;
+
+	std::vector<DrawCommand> commands;
+	std::vector<unsigned int> uploadedMeshRevisions;
+
+	void uploadBody(size_t cube, const RubiksCube::Vertex* vertices, unsigned int meshRevision);
+};
+
+#endif
\ No newline at end of file
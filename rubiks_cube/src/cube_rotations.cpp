@@ -0,0 +1,143 @@
+#include "cube_rotations.h"
+
+#include <array>
+
+namespace
+{
+	using rotations::Matrix;
+	using rotations::NUM_ROTATIONS;
+
+	// Quarter turns counter-clockwise about x, y and z, matching rotatePosition
+	constexpr Matrix GENERATORS[3]
+	{
+		{{{1, 0, 0}, {0, 0, -1}, {0, 1, 0}}},
+		{{{0, 0, 1}, {0, 1, 0}, {-1, 0, 0}}},
+		{{{0, -1, 0}, {1, 0, 0}, {0, 0, 1}}}
+	};
+
+	constexpr Matrix multiply(const Matrix& a, const Matrix& b)
+	{
+		Matrix product{};
+		for(int row = 0; row < 3; row++)
+		{
+			for(int column = 0; column < 3; column++)
+			{
+				int sum = 0;
+				for(int i = 0; i < 3; i++)
+					sum += a.m[row][i] * b.m[i][column];
+				product.m[row][column] = (signed char)sum;
+			}
+		}
+		return product;
+	}
+
+	constexpr bool sameMatrix(const Matrix& a, const Matrix& b)
+	{
+		for(int row = 0; row < 3; row++)
+		{
+			for(int column = 0; column < 3; column++)
+			{
+				if(a.m[row][column] != b.m[row][column])
+					return false;
+			}
+		}
+		return true;
+	}
+
+	struct RotationTables
+	{
+		Matrix matrices[NUM_ROTATIONS];
+		unsigned char compose[NUM_ROTATIONS][NUM_ROTATIONS];
+		unsigned char inverse[NUM_ROTATIONS];
+		unsigned char quarterTurn[3][4];
+	};
+
+	template<size_t N>
+	constexpr int findMatrix(const Matrix (&matrices)[N], int count, const Matrix& matrix)
+	{
+		for(int i = 0; i < count; i++)
+		{
+			if(sameMatrix(matrices[i], matrix))
+				return i;
+		}
+		return -1;
+	}
+
+	// Closure of the identity under the three generators, so the identity is rotation 0
+	constexpr RotationTables buildTables()
+	{
+		RotationTables tables{};
+
+		tables.matrices[0] = {{{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}};
+		int count = 1;
+
+		for(int i = 0; i < count; i++)
+		{
+			for(const Matrix& generator : GENERATORS)
+			{
+				Matrix next = multiply(generator, tables.matrices[i]);
+				if(findMatrix(tables.matrices, count, next) < 0)
+					tables.matrices[count++] = next;
+			}
+		}
+
+		for(int first = 0; first < NUM_ROTATIONS; first++)
+		{
+			for(int second = 0; second < NUM_ROTATIONS; second++)
+			{
+				int composed = findMatrix(tables.matrices, NUM_ROTATIONS, multiply(tables.matrices[second], tables.matrices[first]));
+				tables.compose[first][second] = (unsigned char)composed;
+				if(composed == rotations::IDENTITY)
+					tables.inverse[first] = (unsigned char)second;
+			}
+		}
+
+		for(int axis = 0; axis < 3; axis++)
+		{
+			int rotation = rotations::IDENTITY;
+			for(int quarterTurns = 0; quarterTurns < 4; quarterTurns++)
+			{
+				tables.quarterTurn[axis][quarterTurns] = (unsigned char)rotation;
+				rotation = findMatrix(tables.matrices, NUM_ROTATIONS, multiply(GENERATORS[axis], tables.matrices[rotation]));
+			}
+		}
+
+		return tables;
+	}
+
+	constexpr RotationTables TABLES = buildTables();
+
+	static_assert(TABLES.matrices[NUM_ROTATIONS - 1].m[0][0] || TABLES.matrices[NUM_ROTATIONS - 1].m[0][1]
+				  || TABLES.matrices[NUM_ROTATIONS - 1].m[0][2], "the cube has 24 rotations");
+}
+
+const rotations::Matrix& rotations::matrix(int rotation)
+{
+	return TABLES.matrices[rotation];
+}
+
+CubiePosition rotations::apply(int rotation, CubiePosition position)
+{
+	const Matrix& matrix = TABLES.matrices[rotation];
+
+	signed char rotated[3];
+	for(int row = 0; row < 3; row++)
+		rotated[row] = (signed char)(matrix.m[row][0] * position.x + matrix.m[row][1] * position.y + matrix.m[row][2] * position.z);
+
+	return {rotated[0], rotated[1], rotated[2]};
+}
+
+int rotations::compose(int first, int second)
+{
+	return TABLES.compose[first][second];
+}
+
+int rotations::inverse(int rotation)
+{
+	return TABLES.inverse[rotation];
+}
+
+int rotations::quarterTurn(int axis, int quarterTurns)
+{
+	return TABLES.quarterTurn[axis][quarterTurns % 4];
+}
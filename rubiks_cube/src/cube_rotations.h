@@ -0,0 +1,30 @@
+#ifndef CUBE_ROTATIONS_H
+#define CUBE_ROTATIONS_H
+
+#include "cube_state.h"
+
+// The 24 rotations of a cube as exact integer matrices, so orientations can be stored and compared as one byte
+namespace rotations
+{
+	inline constexpr int
+		NUM_ROTATIONS = 24,
+		IDENTITY = 0;
+
+	// Row-major, rotates column vectors (x, y, z)
+	struct Matrix
+	{
+		signed char m[3][3];
+	};
+
+	const Matrix& matrix(int rotation);
+	CubiePosition apply(int rotation, CubiePosition position);
+
+	// The rotation doing first, then second
+	int compose(int first, int second);
+	int inverse(int rotation);
+
+	// quarterTurns counter-clockwise about the positive axis, as in MoveGeometry
+	int quarterTurn(int axis, int quarterTurns);
+}
+
+#endif
@@ -0,0 +1,349 @@
+#include "cube_state.h"
+
+#include <array>
+#include <algorithm>
+
+namespace
+{
+	struct MoveTable
+	{
+		unsigned char cornerSource[CubeState::NUM_CORNERS];
+		unsigned char cornerTwist[CubeState::NUM_CORNERS];
+		unsigned char edgeSource[CubeState::NUM_EDGES];
+		unsigned char edgeFlip[CubeState::NUM_EDGES];
+		unsigned char centerSource[CubeState::NUM_CENTERS];
+	};
+
+	constexpr bool samePosition(CubiePosition a, CubiePosition b)
+	{
+		return (a.x == b.x) && (a.y == b.y) && (a.z == b.z);
+	}
+
+	constexpr int component(CubiePosition p, int axis)
+	{
+		return (axis == 0) ? p.x : ((axis == 1) ? p.y : p.z);
+	}
+
+	constexpr int determinant(CubiePosition a, CubiePosition b, CubiePosition c)
+	{
+		return a.x * (b.y * c.z - b.z * c.y) - a.y * (b.x * c.z - b.z * c.x) + a.z * (b.x * c.y - b.y * c.x);
+	}
+
+	// Facelet normals of a slot, reference facelet first (U/D, else F/B), the rest clockwise seen from outside
+	constexpr int faceletNormals(CubiePosition p, CubiePosition* normals)
+	{
+		CubiePosition x{p.x, 0, 0}, y{0, p.y, 0}, z{0, 0, p.z};
+
+		if(p.x && p.y && p.z)
+		{
+			normals[0] = y;
+			normals[1] = (determinant(y, x, z) < 0) ? x : z;
+			normals[2] = (determinant(y, x, z) < 0) ? z : x;
+			return 3;
+		}
+		else if(p.y)
+		{
+			normals[0] = y;
+			normals[1] = p.x ? x : z;
+			return 2;
+		}
+		else
+		{
+			normals[0] = z;
+			normals[1] = x;
+			return 2;
+		}
+	}
+
+	template<size_t N>
+	constexpr int findPosition(const CubiePosition (&positions)[N], CubiePosition p)
+	{
+		for(size_t i = 0; i < N; i++)
+		{
+			if(samePosition(positions[i], p))
+				return (int)i;
+		}
+		return -1;
+	}
+
+	template<size_t N>
+	constexpr void buildLayerPermutation(const CubiePosition (&positions)[N], MoveGeometry geometry,
+										 unsigned char* source, unsigned char* orientationDelta)
+	{
+		int axis = geometry.axis;
+		int quarterTurns = geometry.quarterTurns;
+
+		for(size_t target = 0; target < N; target++)
+		{
+			source[target] = (unsigned char)target;
+			if(orientationDelta)
+				orientationDelta[target] = 0;
+
+			int layer = component(positions[target], axis);
+			if((layer < geometry.firstLayer) || (layer > geometry.lastLayer))
+				continue;
+
+			CubiePosition sourcePosition = rotatePosition(positions[target], axis, 4 - quarterTurns);
+			source[target] = (unsigned char)findPosition(positions, sourcePosition);
+
+			if(orientationDelta)
+			{
+				CubiePosition sourceNormals[3]{}, targetNormals[3]{};
+				faceletNormals(sourcePosition, sourceNormals);
+				int numFacelets = faceletNormals(positions[target], targetNormals);
+
+				CubiePosition movedReference = rotatePosition(sourceNormals[0], axis, quarterTurns);
+				for(int facelet = 0; facelet < numFacelets; facelet++)
+				{
+					if(samePosition(targetNormals[facelet], movedReference))
+						orientationDelta[target] = (unsigned char)facelet;
+				}
+			}
+		}
+	}
+
+	constexpr std::array<MoveTable, NUM_MOVES> buildMoveTables()
+	{
+		std::array<MoveTable, NUM_MOVES> tables{};
+
+		for(int move = 0; move < NUM_MOVES; move++)
+		{
+			MoveGeometry geometry = moveGeometry((Move)move);
+
+			MoveTable& table = tables[move];
+			buildLayerPermutation(CubeState::CORNER_POSITIONS, geometry, table.cornerSource, table.cornerTwist);
+			buildLayerPermutation(CubeState::EDGE_POSITIONS, geometry, table.edgeSource, table.edgeFlip);
+			buildLayerPermutation(CubeState::CENTER_POSITIONS, geometry, table.centerSource, nullptr);
+		}
+
+		return tables;
+	}
+
+	constexpr std::array<CubeState::Slot, 27> buildSlotTable()
+	{
+		std::array<CubeState::Slot, 27> slots{};
+
+		for(int index = 0; index < 27; index++)
+		{
+			CubiePosition p{(signed char)(index / 9 - 1), (signed char)(index / 3 % 3 - 1), (signed char)(index % 3 - 1)};
+			int numNonZero = (p.x != 0) + (p.y != 0) + (p.z != 0);
+
+			switch(numNonZero)
+			{
+				case 3 : slots[index] = {CubeState::CUBIE_CORNER, (unsigned char)findPosition(CubeState::CORNER_POSITIONS, p)}; break;
+				case 2 : slots[index] = {CubeState::CUBIE_EDGE, (unsigned char)findPosition(CubeState::EDGE_POSITIONS, p)}; break;
+				case 1 : slots[index] = {CubeState::CUBIE_CENTER, (unsigned char)findPosition(CubeState::CENTER_POSITIONS, p)}; break;
+				default : slots[index] = {CubeState::CUBIE_CORE, 0}; break;
+			}
+		}
+
+		return slots;
+	}
+
+	constexpr std::array<MoveTable, NUM_MOVES> MOVE_TABLES = buildMoveTables();
+	constexpr std::array<CubeState::Slot, 27> SLOT_TABLE = buildSlotTable();
+
+	constexpr unsigned char MOD_3[6] = {0, 1, 2, 0, 1, 2};
+
+	constexpr int NUM_ROTATION_MOVES = NUM_MOVES - MOVE_X;
+
+	bool areCentersHome(const CubeState& state)
+	{
+		for(int i = 0; i < CubeState::NUM_CENTERS; i++)
+		{
+			if(state.centerPermutation[i] != i)
+				return false;
+		}
+		return true;
+	}
+
+	// A face move on the rotated cube is the rotation, then the move, then the rotation undone on the cube as it was,
+	// which is a face move again
+	void mapFaceMoves(const Move* rotation, int rotationLength, Move* faceMoves)
+	{
+		for(int move = 0; move < NUM_FACE_MOVES; move++)
+		{
+			CubeState conjugate;
+			conjugate.applyMoves(rotation, rotationLength);
+			conjugate.applyMove((Move)move);
+			for(int i = rotationLength - 1; i >= 0; i--)
+				conjugate.applyMove(inverseMove(rotation[i]));
+
+			for(int faceMove = 0; faceMove < NUM_FACE_MOVES; faceMove++)
+			{
+				CubeState candidate;
+				candidate.applyMove((Move)faceMove);
+				if(candidate == conjugate)
+					faceMoves[move] = (Move)faceMove;
+			}
+		}
+	}
+
+	// Returns the permutation's parity, or -1 if it isn't a permutation of 0..size-1
+	int permutationParity(const unsigned char* permutation, int size)
+	{
+		bool seen[CubeState::NUM_EDGES]{};
+		for(int i = 0; i < size; i++)
+		{
+			if((permutation[i] >= size) || seen[permutation[i]])
+				return -1;
+			seen[permutation[i]] = true;
+		}
+
+		int parity = 0;
+		for(int i = 0; i < size; i++)
+		{
+			for(int j = i + 1; j < size; j++)
+			{
+				if(permutation[j] < permutation[i])
+					parity ^= 1;
+			}
+		}
+		return parity;
+	}
+}
+
+CubeState::CubeState()
+{
+	for(int i = 0; i < NUM_CORNERS; i++)
+		cornerPermutation[i] = (unsigned char)i;
+	for(int i = 0; i < NUM_EDGES; i++)
+		edgePermutation[i] = (unsigned char)i;
+	for(int i = 0; i < NUM_CENTERS; i++)
+		centerPermutation[i] = (unsigned char)i;
+
+	std::fill(cornerOrientation, cornerOrientation + NUM_CORNERS, 0);
+	std::fill(edgeOrientation, edgeOrientation + NUM_EDGES, 0);
+}
+
+CubeState::Slot CubeState::slotAt(CubiePosition position)
+{
+	return SLOT_TABLE[(position.x + 1) * 9 + (position.y + 1) * 3 + (position.z + 1)];
+}
+
+CubiePosition CubeState::slotPosition(Slot slot)
+{
+	switch(slot.type)
+	{
+		case CUBIE_CORNER : return CORNER_POSITIONS[slot.index];
+		case CUBIE_EDGE : return EDGE_POSITIONS[slot.index];
+		case CUBIE_CENTER : return CENTER_POSITIONS[slot.index];
+		default : return {0, 0, 0};
+	}
+}
+
+CubiePosition CubeState::homePositionAt(CubiePosition position) const
+{
+	Slot slot = slotAt(position);
+
+	switch(slot.type)
+	{
+		case CUBIE_CORNER : return CORNER_POSITIONS[cornerPermutation[slot.index]];
+		case CUBIE_EDGE : return EDGE_POSITIONS[edgePermutation[slot.index]];
+		case CUBIE_CENTER : return CENTER_POSITIONS[centerPermutation[slot.index]];
+		default : return {0, 0, 0};
+	}
+}
+
+void CubeState::applyMove(Move move)
+{
+	const MoveTable& table = MOVE_TABLES[move];
+	const CubeState previous = *this;
+
+	for(int i = 0; i < NUM_CORNERS; i++)
+	{
+		unsigned char source = table.cornerSource[i];
+		cornerPermutation[i] = previous.cornerPermutation[source];
+		cornerOrientation[i] = MOD_3[previous.cornerOrientation[source] + table.cornerTwist[i]];
+	}
+
+	for(int i = 0; i < NUM_EDGES; i++)
+	{
+		unsigned char source = table.edgeSource[i];
+		edgePermutation[i] = previous.edgePermutation[source];
+		edgeOrientation[i] = previous.edgeOrientation[source] ^ table.edgeFlip[i];
+	}
+
+	for(int i = 0; i < NUM_CENTERS; i++)
+		centerPermutation[i] = previous.centerPermutation[table.centerSource[i]];
+}
+
+void CubeState::applyMoves(const Move* moves, size_t numMoves)
+{
+	for(size_t i = 0; i < numMoves; i++)
+		applyMove(moves[i]);
+}
+
+bool CubeState::isSolved() const
+{
+	return *this == CubeState{};
+}
+
+bool CubeState::isSolvable() const
+{
+	// Moved centers only change which way the cube is held, a slice is a face turn and a rotation
+	CubeState rotated = *this;
+	if(!rotated.rotateCentersHome(nullptr))
+		return false;
+
+	int cornerParity = permutationParity(rotated.cornerPermutation, NUM_CORNERS);
+	int edgeParity = permutationParity(rotated.edgePermutation, NUM_EDGES);
+
+	if((cornerParity < 0) || (edgeParity < 0) || (cornerParity != edgeParity))
+		return false;
+
+	int twist = 0, flip = 0;
+	for(int i = 0; i < NUM_CORNERS; i++)
+	{
+		if(rotated.cornerOrientation[i] > 2)
+			return false;
+		twist += rotated.cornerOrientation[i];
+	}
+	for(int i = 0; i < NUM_EDGES; i++)
+	{
+		if(rotated.edgeOrientation[i] > 1)
+			return false;
+		flip += rotated.edgeOrientation[i];
+	}
+
+	return (twist % 3 == 0) && (flip % 2 == 0);
+}
+
+bool CubeState::rotateCentersHome(Move* faceMoves)
+{
+	// Every whole cube rotation is at most two rotation moves, -1 standing for none
+	for(int first = -1; first < NUM_ROTATION_MOVES; first++)
+	{
+		for(int second = -1; second < NUM_ROTATION_MOVES; second++)
+		{
+			Move rotation[2];
+			int rotationLength = 0;
+			if(first >= 0)
+				rotation[rotationLength++] = (Move)(MOVE_X + first);
+			if(second >= 0)
+				rotation[rotationLength++] = (Move)(MOVE_X + second);
+
+			CubeState rotated = *this;
+			rotated.applyMoves(rotation, rotationLength);
+			if(!areCentersHome(rotated))
+				continue;
+
+			if(faceMoves)
+				mapFaceMoves(rotation, rotationLength, faceMoves);
+
+			*this = rotated;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CubeState::operator==(const CubeState& other) const
+{
+	return std::equal(cornerPermutation, cornerPermutation + NUM_CORNERS, other.cornerPermutation)
+		&& std::equal(cornerOrientation, cornerOrientation + NUM_CORNERS, other.cornerOrientation)
+		&& std::equal(edgePermutation, edgePermutation + NUM_EDGES, other.edgePermutation)
+		&& std::equal(edgeOrientation, edgeOrientation + NUM_EDGES, other.edgeOrientation)
+		&& std::equal(centerPermutation, centerPermutation + NUM_CENTERS, other.centerPermutation);
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#ifndef CUBE_STATE_H
+#define CUBE_STATE_H
+
+#include <cstddef>
+
+/*
+	Face order matches RubiksCube::Face, so a face turn is simply (face * NUM_TURNS + turn).
+	Every other family follows the same layout : slice turns (M E S), wide turns (Rw .. Bw)
+	and whole cube rotations (x y z). The solvers only search over the first NUM_FACE_MOVES.
+*/
+enum Move : unsigned char
+{
+	MOVE_R, MOVE_R2, MOVE_R_PRIME,
+	MOVE_L, MOVE_L2, MOVE_L_PRIME,
+	MOVE_U, MOVE_U2, MOVE_U_PRIME,
+	MOVE_D, MOVE_D2, MOVE_D_PRIME,
+	MOVE_F, MOVE_F2, MOVE_F_PRIME,
+	MOVE_B, MOVE_B2, MOVE_B_PRIME,
+
+	MOVE_M, MOVE_M2, MOVE_M_PRIME,
+	MOVE_E, MOVE_E2, MOVE_E_PRIME,
+	MOVE_S, MOVE_S2, MOVE_S_PRIME,
+
+	MOVE_RW, MOVE_RW2, MOVE_RW_PRIME,
+	MOVE_LW, MOVE_LW2, MOVE_LW_PRIME,
+	MOVE_UW, MOVE_UW2, MOVE_UW_PRIME,
+	MOVE_DW, MOVE_DW2, MOVE_DW_PRIME,
+	MOVE_FW, MOVE_FW2, MOVE_FW_PRIME,
+	MOVE_BW, MOVE_BW2, MOVE_BW_PRIME,
+
+	MOVE_X, MOVE_X2, MOVE_X_PRIME,
+	MOVE_Y, MOVE_Y2, MOVE_Y_PRIME,
+	MOVE_Z, MOVE_Z2, MOVE_Z_PRIME,
+
+	NUM_MOVES,
+	NUM_FACE_MOVES = MOVE_M
+};
+
+enum MoveFamily
+{
+	FAMILY_FACE = 0,
+	FAMILY_SLICE = 6,
+	FAMILY_WIDE = 9,
+	FAMILY_ROTATION = 15,
+
+	NUM_MOVE_FAMILIES = 18
+};
+
+enum MoveTurn
+{
+	TURN_CLOCKWISE,
+	TURN_DOUBLE,
+	TURN_COUNTER_CLOCKWISE,
+
+	NUM_TURNS
+};
+
+inline constexpr Move makeMove(int face, MoveTurn turn)
+{
+	return (Move)(face * NUM_TURNS + turn);
+}
+
+// Face of a face turn, for other moves the family index (FAMILY_SLICE + axis, FAMILY_WIDE + face, ..)
+inline constexpr int moveFace(Move move)
+{
+	return (int)move / NUM_TURNS;
+}
+
+inline constexpr MoveTurn moveTurn(Move move)
+{
+	return (MoveTurn)((int)move % NUM_TURNS);
+}
+
+inline constexpr Move inverseMove(Move move)
+{
+	return makeMove(moveFace(move), (MoveTurn)(TURN_COUNTER_CLOCKWISE - moveTurn(move)));
+}
+
+inline constexpr int NO_FACE = -1;
+
+// Same face twice in a row, or opposite faces out of order (R L and L R are the same), never shortens a search
+inline constexpr bool isRedundantMove(int face, int lastFace)
+{
+	return (lastFace != NO_FACE) && ((face == lastFace) || ((face / 2 == lastFace / 2) && (face < lastFace)));
+}
+
+/*
+	A move on an NxNxN cube, reaching past the outer layers : a face turn of depth d turns only the d-th layer in
+	from its face (3R), a wide turn of depth d the d outer layers (3Rw). Depth 0 keeps the move's own layers,
+	slices and rotations ignore it.
+*/
+struct LayerMove
+{
+	Move move;
+	unsigned char depth;
+};
+
+struct CubiePosition
+{
+	signed char x, y, z;
+};
+
+// Axis (0 = x, 1 = y, 2 = z), range of affected layers along it, and quarter turns counter-clockwise about it
+struct MoveGeometry
+{
+	int axis;
+	int firstLayer, lastLayer;
+	int quarterTurns;
+};
+
+inline constexpr MoveGeometry moveGeometry(Move move)
+{
+	int family = moveFace(move);
+
+	// Axis, layers and the face whose clockwise direction the move follows (M like L, E like D, S like F, x y z like R U F)
+	int axis, firstLayer, lastLayer, direction;
+	if(family < FAMILY_SLICE)
+	{
+		axis = family / 2;
+		direction = (family % 2 == 0) ? 1 : -1;
+		firstLayer = lastLayer = direction;
+	}
+	else if(family < FAMILY_WIDE)
+	{
+		axis = family - FAMILY_SLICE;
+		direction = (axis == 2) ? 1 : -1;
+		firstLayer = lastLayer = 0;
+	}
+	else if(family < FAMILY_ROTATION)
+	{
+		axis = (family - FAMILY_WIDE) / 2;
+		direction = ((family - FAMILY_WIDE) % 2 == 0) ? 1 : -1;
+		firstLayer = (direction > 0) ? 0 : -1;
+		lastLayer = firstLayer + 1;
+	}
+	else
+	{
+		axis = family - FAMILY_ROTATION;
+		direction = 1;
+		firstLayer = -1;
+		lastLayer = 1;
+	}
+
+	// Clockwise seen from outside the face is clockwise about the outward normal
+	int clockwiseTurns = moveTurn(move) + 1;
+	int quarterTurns = (direction > 0) ? (4 - clockwiseTurns) : clockwiseTurns;
+
+	return {axis, firstLayer, lastLayer, quarterTurns};
+}
+
+inline constexpr CubiePosition rotatePosition(CubiePosition p, int axis, int quarterTurns)
+{
+	for(int turn = 0; turn < quarterTurns; turn++)
+	{
+		switch(axis)
+		{
+			case 0 : p = {p.x, (signed char)-p.z, p.y}; break;
+			case 1 : p = {p.z, p.y, (signed char)-p.x}; break;
+			default : p = {(signed char)-p.y, p.x, p.z}; break;
+		}
+	}
+
+	return p;
+}
+
+/*
+	Logical state of a 3x3x3 cube as permutation/orientation arrays.
+	Slots follow the usual URF.. / UR.. ordering with U = +y, R = +x and F = +z.
+	Permutation entries hold the home slot of the cubie currently in a slot, orientation entries
+	hold the facelet (in clockwise order, starting from the U/D or F/B facelet) that the cubie's
+	reference facelet currently occupies.
+*/
+class CubeState
+{
+public :
+	static constexpr int
+		NUM_CORNERS = 8,
+		NUM_EDGES = 12,
+		NUM_CENTERS = 6;
+
+	enum CubieType
+	{
+		CUBIE_CORNER,
+		CUBIE_EDGE,
+		CUBIE_CENTER,
+		CUBIE_CORE
+	};
+
+	struct Slot
+	{
+		CubieType type;
+		unsigned char index;
+	};
+
+	static constexpr CubiePosition CORNER_POSITIONS[NUM_CORNERS]
+	{
+		{1, 1, 1}, {-1, 1, 1}, {-1, 1, -1}, {1, 1, -1},
+		{1, -1, 1}, {-1, -1, 1}, {-1, -1, -1}, {1, -1, -1}
+	};
+
+	static constexpr CubiePosition EDGE_POSITIONS[NUM_EDGES]
+	{
+		{1, 1, 0}, {0, 1, 1}, {-1, 1, 0}, {0, 1, -1},
+		{1, -1, 0}, {0, -1, 1}, {-1, -1, 0}, {0, -1, -1},
+		{1, 0, 1}, {-1, 0, 1}, {-1, 0, -1}, {1, 0, -1}
+	};
+
+	static constexpr CubiePosition CENTER_POSITIONS[NUM_CENTERS]
+	{
+		{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+	};
+
+	unsigned char cornerPermutation[NUM_CORNERS];
+	unsigned char cornerOrientation[NUM_CORNERS];
+	unsigned char edgePermutation[NUM_EDGES];
+	unsigned char edgeOrientation[NUM_EDGES];
+	unsigned char centerPermutation[NUM_CENTERS];
+
+	CubeState();
+
+	static Slot slotAt(CubiePosition position);
+	static CubiePosition slotPosition(Slot slot);
+
+	CubiePosition homePositionAt(CubiePosition position) const;
+
+	void applyMove(Move move);
+	void applyMoves(const Move* moves, size_t numMoves);
+
+	bool isSolved() const;
+	bool isSolvable() const;
+
+	// Turns the whole cube so the centers are home, as slices, wide turns and rotations move them. faceMoves, if given,
+	// receives for each face move on the turned cube the same move on the cube as it was. False if no rotation does it
+	bool rotateCentersHome(Move* faceMoves);
+	bool operator==(const CubeState& other) const;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,221 @@
+#include "facelet_cube.h"
+
+#include <array>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX512VBMI__) || defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	constexpr int NUM_LANES = FaceletCube::NUM_BYTES / 16;
+	constexpr unsigned char LANE_ZERO = 0x80;
+
+	struct alignas(64) FaceletShuffle
+	{
+		// Full permutation, new facelet i = old facelet source[i]
+		unsigned char source[FaceletCube::NUM_BYTES];
+
+		// Per source lane, (p)shufb controls producing that lane's contribution to every output byte
+		unsigned char laneMasks[NUM_LANES][FaceletCube::NUM_BYTES];
+	};
+
+	int component(CubiePosition p, int axis)
+	{
+		return (axis == 0) ? p.x : ((axis == 1) ? p.y : p.z);
+	}
+
+	CubiePosition faceNormal(int face)
+	{
+		signed char sign = (face % 2 == 0) ? 1 : -1;
+		switch(face / 2)
+		{
+			case 0 : return {sign, 0, 0};
+			case 1 : return {0, sign, 0};
+			default : return {0, 0, sign};
+		}
+	}
+
+	int faceFromNormal(CubiePosition normal)
+	{
+		for(int face = 0; face < FaceletCube::NUM_FACES; face++)
+		{
+			CubiePosition faceNormalPosition = faceNormal(face);
+			if((faceNormalPosition.x == normal.x) && (faceNormalPosition.y == normal.y) && (faceNormalPosition.z == normal.z))
+				return face;
+		}
+		return -1;
+	}
+
+	int faceletAt(int face, CubiePosition position)
+	{
+		for(int i = 0; i < FaceletCube::NUM_FACELETS_PER_FACE; i++)
+		{
+			CubiePosition faceletPosition = FaceletCube::FACELET_POSITIONS[face][i];
+			if((faceletPosition.x == position.x) && (faceletPosition.y == position.y) && (faceletPosition.z == position.z))
+				return face * FaceletCube::NUM_FACELETS_PER_FACE + i;
+		}
+		return -1;
+	}
+
+	std::array<FaceletShuffle, NUM_MOVES> buildShuffles()
+	{
+		std::array<FaceletShuffle, NUM_MOVES> shuffles{};
+
+		for(int move = 0; move < NUM_MOVES; move++)
+		{
+			MoveGeometry geometry = moveGeometry((Move)move);
+			FaceletShuffle& shuffle = shuffles[move];
+
+			for(int target = 0; target < FaceletCube::NUM_BYTES; target++)
+			{
+				shuffle.source[target] = (unsigned char)target;
+				if(target >= FaceletCube::NUM_FACELETS)
+					continue;
+
+				int face = target / FaceletCube::NUM_FACELETS_PER_FACE;
+				CubiePosition position = FaceletCube::FACELET_POSITIONS[face][target % FaceletCube::NUM_FACELETS_PER_FACE];
+
+				int layer = component(position, geometry.axis);
+				if((layer < geometry.firstLayer) || (layer > geometry.lastLayer))
+					continue;
+
+				int inverseTurns = 4 - geometry.quarterTurns;
+				CubiePosition sourcePosition = rotatePosition(position, geometry.axis, inverseTurns);
+				int sourceFace = faceFromNormal(rotatePosition(faceNormal(face), geometry.axis, inverseTurns));
+
+				shuffle.source[target] = (unsigned char)faceletAt(sourceFace, sourcePosition);
+			}
+
+			for(int lane = 0; lane < NUM_LANES; lane++)
+			{
+				for(int target = 0; target < FaceletCube::NUM_BYTES; target++)
+				{
+					int source = shuffle.source[target];
+					shuffle.laneMasks[lane][target] = (source / 16 == lane) ? (unsigned char)(source % 16) : LANE_ZERO;
+				}
+			}
+		}
+
+		return shuffles;
+	}
+
+	const std::array<FaceletShuffle, NUM_MOVES> SHUFFLES = buildShuffles();
+
+#if !defined(__AVX512VBMI__) && defined(__AVX2__)
+	inline __m256i shuffleHalf(const __m256i lanes[NUM_LANES], const FaceletShuffle& shuffle, int half)
+	{
+		__m256i result = _mm256_setzero_si256();
+		for(int lane = 0; lane < NUM_LANES; lane++)
+		{
+			__m256i mask = _mm256_load_si256((const __m256i*)(shuffle.laneMasks[lane] + 32 * half));
+			result = _mm256_or_si256(result, _mm256_shuffle_epi8(lanes[lane], mask));
+		}
+		return result;
+	}
+#elif !defined(__AVX512VBMI__) && defined(__SSSE3__)
+	inline __m128i shuffleLane(const __m128i lanes[NUM_LANES], const FaceletShuffle& shuffle, int outputLane)
+	{
+		__m128i result = _mm_setzero_si128();
+		for(int lane = 0; lane < NUM_LANES; lane++)
+		{
+			__m128i mask = _mm_load_si128((const __m128i*)(shuffle.laneMasks[lane] + 16 * outputLane));
+			result = _mm_or_si128(result, _mm_shuffle_epi8(lanes[lane], mask));
+		}
+		return result;
+	}
+#endif
+}
+
+FaceletCube::FaceletCube()
+{
+	for(int i = 0; i < NUM_BYTES; i++)
+		facelets[i] = (i < NUM_FACELETS) ? (unsigned char)(i / NUM_FACELETS_PER_FACE) : 0;
+}
+
+void FaceletCube::applyMove(Move move)
+{
+	applyMoves(&move, 1);
+}
+
+void FaceletCube::applyMoves(const Move* moves, size_t numMoves)
+{
+#if defined(__AVX512VBMI__)
+
+	__m512i cube = _mm512_load_si512(facelets);
+	for(size_t i = 0; i < numMoves; i++)
+		cube = _mm512_permutexvar_epi8(_mm512_load_si512(SHUFFLES[moves[i]].source), cube);
+	_mm512_store_si512(facelets, cube);
+
+#elif defined(__AVX2__)
+
+	__m256i low = _mm256_load_si256((const __m256i*)facelets);
+	__m256i high = _mm256_load_si256((const __m256i*)(facelets + 32));
+
+	for(size_t i = 0; i < numMoves; i++)
+	{
+		// vpshufb only shuffles within 128-bit lanes, so each source lane is broadcast to both halves first
+		__m256i lanes[NUM_LANES]
+		{
+			_mm256_permute2x128_si256(low, low, 0x00),
+			_mm256_permute2x128_si256(low, low, 0x11),
+			_mm256_permute2x128_si256(high, high, 0x00),
+			_mm256_permute2x128_si256(high, high, 0x11)
+		};
+
+		const FaceletShuffle& shuffle = SHUFFLES[moves[i]];
+		low = shuffleHalf(lanes, shuffle, 0);
+		high = shuffleHalf(lanes, shuffle, 1);
+	}
+
+	_mm256_store_si256((__m256i*)facelets, low);
+	_mm256_store_si256((__m256i*)(facelets + 32), high);
+
+#elif defined(__SSSE3__)
+
+	__m128i lanes[NUM_LANES];
+	for(int lane = 0; lane < NUM_LANES; lane++)
+		lanes[lane] = _mm_load_si128((const __m128i*)(facelets + 16 * lane));
+
+	for(size_t i = 0; i < numMoves; i++)
+	{
+		const FaceletShuffle& shuffle = SHUFFLES[moves[i]];
+		__m128i shuffled[NUM_LANES];
+		for(int lane = 0; lane < NUM_LANES; lane++)
+			shuffled[lane] = shuffleLane(lanes, shuffle, lane);
+		std::copy(shuffled, shuffled + NUM_LANES, lanes);
+	}
+
+	for(int lane = 0; lane < NUM_LANES; lane++)
+		_mm_store_si128((__m128i*)(facelets + 16 * lane), lanes[lane]);
+
+#else
+
+	applyMovesScalar(moves, numMoves);
+
+#endif
+}
+
+void FaceletCube::applyMovesScalar(const Move* moves, size_t numMoves)
+{
+	alignas(64) unsigned char previous[NUM_BYTES];
+	for(size_t i = 0; i < numMoves; i++)
+	{
+		const unsigned char* source = SHUFFLES[moves[i]].source;
+		std::memcpy(previous, facelets, NUM_FACELETS);
+		for(int facelet = 0; facelet < NUM_FACELETS; facelet++)
+			facelets[facelet] = previous[source[facelet]];
+	}
+}
+
+bool FaceletCube::isSolved() const
+{
+	return *this == FaceletCube{};
+}
+
+bool FaceletCube::operator==(const FaceletCube& other) const
+{
+	return std::memcmp(facelets, other.facelets, NUM_BYTES) == 0;
+}
\ No newline at end of file
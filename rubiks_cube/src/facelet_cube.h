@@ -0,0 +1,69 @@
+#ifndef FACELET_CUBE_H
+#define FACELET_CUBE_H
+
+#include "cube_state.h"
+
+/*
+	Facelet-level 3x3x3 state packed into one 64-byte block.
+	Facelet (face * 9 + i) is the sticker at FACELET_POSITIONS[face][i] and holds the face
+	whose color it shows, the last 10 bytes are padding. Every move is a single precomputed byte shuffle,
+	done with vpermb (AVX-512 VBMI), vpshufb (AVX2) or pshufb (SSSE3) when the build targets them.
+*/
+class alignas(64) FaceletCube
+{
+public :
+	static constexpr int
+		NUM_FACELETS = 54,
+		NUM_FACES = 6,
+		NUM_FACELETS_PER_FACE = 9,
+		NUM_BYTES = 64;
+
+	// Cubie position of every sticker, faces in Move face order
+	static constexpr CubiePosition FACELET_POSITIONS[NUM_FACES][NUM_FACELETS_PER_FACE]
+	{
+		// face +x
+		{{1, 1, 1}, {1, 1, 0}, {1, 1, -1},
+		{1, 0, 1}, {1, 0, 0}, {1, 0, -1},
+		{1, -1, 1}, {1, -1, 0}, {1, -1, -1}},
+
+		// face -x
+		{{-1, 1, -1}, {-1, 1, 0}, {-1, 1, 1},
+		{-1, 0, -1}, {-1, 0, 0}, {-1, 0, 1},
+		{-1, -1, -1}, {-1, -1, 0}, {-1, -1, 1}},
+
+		// face +y
+		{{-1, 1, -1}, {0, 1, -1}, {1, 1, -1},
+		{-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
+		{-1, 1, 1}, {0, 1, 1}, {1, 1, 1}},
+
+		// face -y
+		{{1, -1, -1}, {0, -1, -1}, {-1, -1, -1},
+		{1, -1, 0}, {0, -1, 0}, {-1, -1, 0},
+		{1, -1, 1}, {0, -1, 1}, {-1, -1, 1}},
+
+		// face +z
+		{{-1, 1, 1}, {0, 1, 1}, {1, 1, 1},
+		{-1, 0, 1}, {0, 0, 1}, {1, 0, 1},
+		{-1, -1, 1}, {0, -1, 1}, {1, -1, 1}},
+
+		// face -z
+		{{1, 1, -1}, {0, 1, -1}, {-1, 1, -1},
+		{1, 0, -1}, {0, 0, -1}, {-1, 0, -1},
+		{1, -1, -1}, {0, -1, -1}, {-1, -1, -1}}
+	};
+
+	unsigned char facelets[NUM_BYTES];
+
+	FaceletCube();
+
+	void applyMove(Move move);
+	void applyMoves(const Move* moves, size_t numMoves);
+
+	// The portable kernel, always built, which the one applyMoves() uses must agree with
+	void applyMovesScalar(const Move* moves, size_t numMoves);
+
+	bool isSolved() const;
+	bool operator==(const FaceletCube& other) const;
+};
+
+#endif
\ No newline at end of file
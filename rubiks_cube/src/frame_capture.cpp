@@ -0,0 +1,133 @@
+#include "frame_capture.h"
+
+#include <stdio.h>
+
+FrameCapture::FrameCapture(int width, int height) :
+	width{width}, height{height}, framebuffer{0}, colorRenderbuffer{0}, depthRenderbuffer{0},
+	pixelBuffers{}, nextPixelBuffer{0},
+	image((size_t)width * height * 3)
+{
+	glGenRenderbuffers(1, &colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &depthRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRenderbuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, depthRenderbuffer);
+
+	if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		printf("Offscreen framebuffer is incomplete\n");
+
+	for(PixelBuffer& pixelBuffer : pixelBuffers)
+	{
+		glGenBuffers(1, &pixelBuffer.buffer);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)width * height * 4, nullptr, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+FrameCapture::~FrameCapture()
+{
+	finish();
+
+	for(PixelBuffer& pixelBuffer : pixelBuffers)
+		glDeleteBuffers(1, &pixelBuffer.buffer);
+
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorRenderbuffer);
+	glDeleteRenderbuffers(1, &depthRenderbuffer);
+}
+
+void FrameCapture::bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, width, height);
+}
+
+bool FrameCapture::capture(const char* path)
+{
+	PixelBuffer& pixelBuffer = pixelBuffers[nextPixelBuffer];
+	nextPixelBuffer = (nextPixelBuffer + 1) % NUM_PIXEL_BUFFERS;
+
+	// The buffer still holds the frame from NUM_PIXEL_BUFFERS captures ago, which has had that long to arrive
+	bool success = writeFrame(pixelBuffer);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	pixelBuffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	pixelBuffer.path = path;
+
+	return success;
+}
+
+bool FrameCapture::finish()
+{
+	bool success = true;
+
+	// Oldest first, so the files are written in the order they were captured
+	for(int i = 0; i < NUM_PIXEL_BUFFERS; i++)
+		success &= writeFrame(pixelBuffers[(nextPixelBuffer + i) % NUM_PIXEL_BUFFERS]);
+
+	return success;
+}
+
+bool FrameCapture::writeFrame(PixelBuffer& pixelBuffer)
+{
+	if(!pixelBuffer.fence)
+		return true;
+
+	while(glClientWaitSync(pixelBuffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+	glDeleteSync(pixelBuffer.fence);
+	pixelBuffer.fence = nullptr;
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer.buffer);
+	const unsigned char* pixels = (const unsigned char*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+																		  (GLsizeiptr)width * height * 4, GL_MAP_READ_BIT);
+	if(!pixels)
+	{
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		printf("Failed to map pixel buffer for %s\n", pixelBuffer.path.c_str());
+		return false;
+	}
+
+	// OpenGL rows go bottom to top, PPM rows top to bottom
+	unsigned char* out = image.data();
+	for(int row = height - 1; row >= 0; row--)
+	{
+		const unsigned char* in = pixels + (size_t)row * width * 4;
+		for(int column = 0; column < width; column++, in += 4, out += 3)
+		{
+			out[0] = in[0];
+			out[1] = in[1];
+			out[2] = in[2];
+		}
+	}
+
+	glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	FILE* file = fopen(pixelBuffer.path.c_str(), "wb");
+	if(!file)
+	{
+		printf("Failed to open %s\n", pixelBuffer.path.c_str());
+		return false;
+	}
+
+	fprintf(file, "P6\n%d %d\n255\n", width, height);
+	bool success = fwrite(image.data(), 1, image.size(), file) == image.size();
+	success &= fclose(file) == 0;
+
+	if(!success)
+		printf("Failed to write %s\n", pixelBuffer.path.c_str());
+
+	return success;
+}
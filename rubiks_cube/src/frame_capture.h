@@ -0,0 +1,51 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include "util.h"
+
+#include <string>
+#include <vector>
+
+/*
+	Offscreen render target whose frames are written out as binary PPM images.
+	Each captured frame is copied into the next of a ring of pixel buffers and fenced, and is only mapped and written
+	once the ring comes back around to it, so the GPU copy overlaps with drawing the following frames and with
+	writing the earlier ones instead of stalling every frame like a plain glReadPixels.
+*/
+class FrameCapture
+{
+public :
+	static constexpr int NUM_PIXEL_BUFFERS = 3;
+
+	FrameCapture(int width, int height);
+	~FrameCapture();
+
+	// Draw calls after this go to the offscreen framebuffer
+	void bind() const;
+
+	// Queues the framebuffer contents to be written to path. Returns false if an earlier frame could not be written
+	bool capture(const char* path);
+
+	// Writes every frame still queued
+	bool finish();
+
+private :
+	struct PixelBuffer
+	{
+		unsigned int buffer;
+		GLsync fence;
+		std::string path;
+	};
+
+	const int width, height;
+	unsigned int framebuffer, colorRenderbuffer, depthRenderbuffer;
+
+	PixelBuffer pixelBuffers[NUM_PIXEL_BUFFERS];
+	int nextPixelBuffer;
+
+	std::vector<unsigned char> image;
+
+	bool writeFrame(PixelBuffer& pixelBuffer);
+};
+
+#endif
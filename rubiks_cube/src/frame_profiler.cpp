@@ -0,0 +1,163 @@
+#include "frame_profiler.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Smallest duration with a bucket of its own, in milliseconds
+	constexpr double FIRST_BUCKET_MS = 0.001;
+
+	double percentile(const std::vector<float>& sorted, double fraction)
+	{
+		size_t index = (size_t)std::ceil(fraction * sorted.size());
+		return sorted[std::min(std::max(index, (size_t)1), sorted.size()) - 1];
+	}
+}
+
+FrameProfiler::FrameProfiler() :
+	mutex{}, phases{}
+{}
+
+int FrameProfiler::addPhase(const char* name)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	phases.push_back({name, std::vector<float>(WINDOW_SAMPLES), 0, {}, 0.0, 0.0});
+	return (int)phases.size() - 1;
+}
+
+int FrameProfiler::bucket(double milliseconds)
+{
+	if(milliseconds <= FIRST_BUCKET_MS)
+		return 0;
+
+	int index = (int)(std::log2(milliseconds / FIRST_BUCKET_MS) * BUCKETS_PER_DOUBLING) + 1;
+	return std::min(index, NUM_BUCKETS - 1);
+}
+
+double FrameProfiler::bucketUpperBound(int bucket)
+{
+	return FIRST_BUCKET_MS * std::exp2((double)bucket / BUCKETS_PER_DOUBLING);
+}
+
+void FrameProfiler::record(int phase, double milliseconds)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	Phase& recorded = phases[phase];
+
+	recorded.window[recorded.numRecorded % WINDOW_SAMPLES] = (float)milliseconds;
+	recorded.numRecorded++;
+
+	recorded.buckets[bucket(milliseconds)]++;
+	recorded.sum += milliseconds;
+	recorded.max = std::max(recorded.max, milliseconds);
+}
+
+FrameProfiler::Clock::time_point FrameProfiler::record(int phase, Clock::time_point start)
+{
+	Clock::time_point now = Clock::now();
+	record(phase, std::chrono::duration<double, std::milli>{now - start}.count());
+	return now;
+}
+
+FrameProfiler::Summary FrameProfiler::recent(int phase) const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const Phase& recorded = phases[phase];
+
+	size_t count = std::min(recorded.numRecorded, (size_t)WINDOW_SAMPLES);
+	if(count == 0)
+		return {0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+	std::vector<float> sorted{recorded.window.begin(), recorded.window.begin() + count};
+	std::sort(sorted.begin(), sorted.end());
+
+	double sum = 0.0;
+	for(float milliseconds : sorted)
+		sum += milliseconds;
+
+	return {count, sum / count, percentile(sorted, 0.5), percentile(sorted, 0.95), percentile(sorted, 0.99), sorted.back()};
+}
+
+FrameProfiler::Summary FrameProfiler::total(int phase) const
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	const Phase& recorded = phases[phase];
+
+	if(recorded.numRecorded == 0)
+		return {0, 0.0, 0.0, 0.0, 0.0, 0.0};
+
+	// A percentile is the upper bound of the bucket it falls in, never more than the largest duration
+	const double fractions[3] = {0.5, 0.95, 0.99};
+	double percentiles[3];
+
+	unsigned long long seen = 0;
+	int bucket = 0;
+	for(int i = 0; i < 3; i++)
+	{
+		unsigned long long rank = (unsigned long long)std::ceil(fractions[i] * recorded.numRecorded);
+		while(seen + recorded.buckets[bucket] < rank)
+			seen += recorded.buckets[bucket++];
+
+		percentiles[i] = std::min(bucketUpperBound(bucket), recorded.max);
+	}
+
+	return {recorded.numRecorded, recorded.sum / recorded.numRecorded, percentiles[0], percentiles[1], percentiles[2], recorded.max};
+}
+
+bool FrameProfiler::save(const char* path) const
+{
+	FILE* file = fopen(path, "w");
+	if(!file)
+	{
+		printf("Failed to open %s\n", path);
+		return false;
+	}
+
+	size_t pathLength = std::strlen(path);
+	bool json = (pathLength >= 5) && (std::strcmp(path + pathLength - 5, ".json") == 0);
+
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		for(const Phase& phase : phases)
+			names.push_back(phase.name);
+	}
+
+	size_t numPhases = names.size();
+
+	fprintf(file, json ? "{\n\t\"phases\" :\n\t[\n" : "phase,count,mean_ms,p50_ms,p95_ms,p99_ms,max_ms\n");
+
+	for(size_t phase = 0; phase < numPhases; phase++)
+	{
+		Summary summary = total((int)phase);
+		const char* name = names[phase].c_str();
+
+		if(json)
+		{
+			fprintf(file, "\t\t{\"name\" : \"%s\", \"count\" : %zu, \"mean_ms\" : %.4f, \"p50_ms\" : %.4f, \"p95_ms\" : %.4f, "
+						  "\"p99_ms\" : %.4f, \"max_ms\" : %.4f}%s\n",
+					name, summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max,
+					(phase + 1 < numPhases) ? "," : "");
+		}
+		else
+		{
+			fprintf(file, "%s,%zu,%.4f,%.4f,%.4f,%.4f,%.4f\n",
+					name, summary.count, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+		}
+	}
+
+	if(json)
+		fprintf(file, "\t]\n}\n");
+
+	bool success = !ferror(file);
+	success &= fclose(file) == 0;
+
+	if(!success)
+		printf("Failed to write %s\n", path);
+
+	return success;
+}
\ No newline at end of file
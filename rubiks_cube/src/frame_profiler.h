@@ -0,0 +1,66 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+	Durations of named phases, recorded from any thread.
+	Each phase keeps its last WINDOW_SAMPLES durations for recent percentiles, and a histogram of every duration
+	since the start (8 buckets per doubling, from 1 us) for percentiles over the whole run. All times are milliseconds.
+*/
+class FrameProfiler
+{
+public :
+	typedef std::chrono::steady_clock Clock;
+
+	static constexpr int
+		WINDOW_SAMPLES = 1024,
+		BUCKETS_PER_DOUBLING = 8,
+		NUM_BUCKETS = 32 * BUCKETS_PER_DOUBLING;
+
+	struct Summary
+	{
+		size_t count;
+		double mean, p50, p95, p99, max;
+	};
+
+	FrameProfiler();
+
+	// Phases are numbered in the order they are added
+	int addPhase(const char* name);
+
+	void record(int phase, double milliseconds);
+
+	// Records the time since start and returns now, to time the next phase from
+	Clock::time_point record(int phase, Clock::time_point start);
+
+	// Over the last WINDOW_SAMPLES durations, and over the whole run
+	Summary recent(int phase) const;
+	Summary total(int phase) const;
+
+	// Every phase's whole run summary, as JSON if the path ends in .json and as CSV otherwise
+	bool save(const char* path) const;
+
+private :
+	struct Phase
+	{
+		std::string name;
+
+		std::vector<float> window;
+		size_t numRecorded;
+
+		unsigned long long buckets[NUM_BUCKETS];
+		double sum, max;
+	};
+
+	mutable std::mutex mutex;
+	std::vector<Phase> phases;
+
+	static int bucket(double milliseconds);
+	static double bucketUpperBound(int bucket);
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "input_log.h"
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <cstring>
+
+namespace
+{
+	constexpr char INPUT_LOG_MAGIC[8] = {'R', 'C', 'I', 'N', 'P', 'U', 'T', '1'};
+
+	struct Header
+	{
+		char magic[8];
+		unsigned int seed;
+		int cubeSize, wallCubes;
+		float stepSeconds;
+		unsigned int numSteps;
+		unsigned int numEvents;
+	};
+
+	struct EventHeader
+	{
+		unsigned int step;
+		float time;
+		unsigned char type, action;
+		short code;
+	};
+
+	static_assert(sizeof(Header) == 32, "Header is written to disk as is");
+	static_assert(sizeof(EventHeader) == 12, "EventHeader is written to disk as is");
+
+	bool hasPosition(InputLog::EventType type)
+	{
+		return type != InputLog::EVENT_KEY;
+	}
+}
+
+InputLog::InputLog() :
+	seed{0}, cubeSize{0}, wallCubes{0}, stepSeconds{0.0f}, numSteps{0}, events{}
+{}
+
+bool InputLog::load(const char* path)
+{
+	MappedFile file;
+	if(!file.open(path))
+	{
+		printf("Failed to open %s\n", path);
+		return false;
+	}
+
+	Header header;
+	if((file.size() < sizeof(header)) ||
+	   (std::memcmp(file.data(), INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC)) != 0))
+	{
+		printf("%s is not an input log\n", path);
+		return false;
+	}
+
+	std::memcpy(&header, file.data(), sizeof(header));
+	seed = header.seed;
+	cubeSize = header.cubeSize;
+	wallCubes = header.wallCubes;
+	stepSeconds = header.stepSeconds;
+	numSteps = header.numSteps;
+
+	events.clear();
+	events.reserve(header.numEvents);
+
+	size_t offset = sizeof(header);
+	for(unsigned int i = 0; i < header.numEvents; i++)
+	{
+		EventHeader eventHeader;
+		if(offset + sizeof(eventHeader) > file.size())
+			break;
+
+		std::memcpy(&eventHeader, file.data() + offset, sizeof(eventHeader));
+		offset += sizeof(eventHeader);
+
+		Event event{eventHeader.step, eventHeader.time, (EventType)eventHeader.type, eventHeader.action, eventHeader.code, 0.0, 0.0};
+		if(hasPosition(event.type))
+		{
+			if(offset + 2 * sizeof(double) > file.size())
+				break;
+
+			std::memcpy(&event.x, file.data() + offset, sizeof(double));
+			std::memcpy(&event.y, file.data() + offset + sizeof(double), sizeof(double));
+			offset += 2 * sizeof(double);
+		}
+
+		events.push_back(event);
+	}
+
+	if(events.size() != header.numEvents)
+	{
+		printf("%s is truncated\n", path);
+		return false;
+	}
+
+	return true;
+}
+
+bool InputLog::save(const char* path) const
+{
+	std::vector<unsigned char> data(sizeof(Header));
+
+	Header header{};
+	std::memcpy(header.magic, INPUT_LOG_MAGIC, sizeof(INPUT_LOG_MAGIC));
+	header.seed = seed;
+	header.cubeSize = cubeSize;
+	header.wallCubes = wallCubes;
+	header.stepSeconds = stepSeconds;
+	header.numSteps = numSteps;
+	header.numEvents = (unsigned int)events.size();
+	std::memcpy(data.data(), &header, sizeof(header));
+
+	for(const Event& event : events)
+	{
+		EventHeader eventHeader{event.step, event.time, event.type, event.action, event.code};
+
+		size_t offset = data.size();
+		data.resize(offset + sizeof(eventHeader) + (hasPosition(event.type) ? 2 * sizeof(double) : 0));
+		std::memcpy(data.data() + offset, &eventHeader, sizeof(eventHeader));
+
+		if(hasPosition(event.type))
+		{
+			std::memcpy(data.data() + offset + sizeof(eventHeader), &event.x, sizeof(double));
+			std::memcpy(data.data() + offset + sizeof(eventHeader) + sizeof(double), &event.y, sizeof(double));
+		}
+	}
+
+	if(!MappedFile::write(path, data.data(), data.size()))
+	{
+		printf("Failed to write %s\n", path);
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <stddef.h>
+#include <vector>
+
+/*
+	The input of an interactive session, with what is needed to play it again exactly : the random seed, the cubes
+	and the fixed step the session ran at. Events are tagged with the step that handled them.
+	On disk a 32 byte header, then 12 bytes per key event and 28 per mouse event.
+*/
+class InputLog
+{
+public :
+	enum EventType : unsigned char
+	{
+		EVENT_KEY,
+		EVENT_MOUSE_BUTTON,
+		EVENT_CURSOR
+	};
+
+	struct Event
+	{
+		unsigned int step;
+		float time; // seconds into the session, only informative
+		EventType type;
+		unsigned char action; // GLFW_PRESS or GLFW_RELEASE, unused for EVENT_CURSOR
+		short code; // GLFW key or mouse button
+		double x, y; // cursor position, mouse events only
+	};
+
+	unsigned int seed;
+	int cubeSize, wallCubes;
+	float stepSeconds;
+	unsigned int numSteps;
+
+	std::vector<Event> events;
+
+	InputLog();
+
+	bool load(const char* path);
+	bool save(const char* path) const;
+};
+
+#endif
\ No newline at end of file
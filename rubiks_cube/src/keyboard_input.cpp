@@ -1,129 +1,150 @@
 #include "keyboard_input.h"
 
-KeyboardInput::KeyboardInput(GLFWwindow* glfwWindow) : 
-	keyNameMap{}, keyStatusMap{}, window{glfwWindow}
-{}
+#include <stdio.h>
 
-void KeyboardInput::setKeybind(const char* keyName, int glfwKey)
+KeyboardInput::KeyboardInput() : 
+	events{}, firstEvent{0}, numEvents{0}, eventsDropped{false},
+	bound{0}, current{0}, justPressed{0}, justReleased{0}, latest{0}
 {
-	keyNameMap[keyName] = glfwKey;
-	keyStatusMap[glfwKey] = {false, false};
+	for(int& action : keyActions)
+		action = -1;
+
+	for(int& key : actionKeys)
+		key = -1;
 }
 
-void KeyboardInput::removeKeybind(const char* keyName)
+KeyboardInput::ActionMask KeyboardInput::bit(int action)
 {
-	auto it = keyNameMap.find(keyName);
-	if(it != keyNameMap.end())
-	{
-		keyStatusMap.erase(it->second);
-		keyNameMap.erase(it);
-	}
+	return (ActionMask)1 << action;
 }
 
-void KeyboardInput::update()
+bool KeyboardInput::setKeybind(int action, int glfwKey)
 {
-	for(auto& [key, status] : keyStatusMap)
+	if((action < 0) || (action >= MAX_ACTIONS) || (glfwKey < 0) || (glfwKey > GLFW_KEY_LAST))
 	{
-		status.previous = status.current;
-		if(glfwGetKey(window, key) == GLFW_PRESS)
-			status.current = true;
-		else
-			status.current = false;
+		printf("Cannot bind key %d to action %d\n", glfwKey, action);
+		return false;
 	}
+
+	removeKeybind(action);
+
+	if(keyActions[glfwKey] >= 0)
+		removeKeybind(keyActions[glfwKey]);
+
+	keyActions[glfwKey] = action;
+	actionKeys[action] = glfwKey;
+	bound |= bit(action);
+	return true;
 }
 
-bool KeyboardInput::keyJustPressed(const char* keyName) const
+void KeyboardInput::removeKeybind(int action)
 {
-	auto it = keyNameMap.find(keyName);
-	if(it != keyNameMap.end())
-	{
-		const KeyStatus& status = keyStatusMap.at(it->second);
-		return status.current && !status.previous;
-	}
-	else
+	if((action < 0) || (action >= MAX_ACTIONS))
+		return;
+
+	if(actionKeys[action] >= 0)
 	{
-		return false;
+		keyActions[actionKeys[action]] = -1;
+		actionKeys[action] = -1;
 	}
+
+	bound &= ~bit(action);
+	current &= ~bit(action);
+	latest &= ~bit(action);
+	justPressed &= ~bit(action);
+	justReleased &= ~bit(action);
 }
 
-bool KeyboardInput::keyPressed(const char* keyName) const
+void KeyboardInput::keyEvent(int glfwKey, int glfwAction)
 {
-	auto it = keyNameMap.find(keyName);
-	if(it != keyNameMap.end())
-	{
-		const KeyStatus& status = keyStatusMap.at(it->second);
-		return status.current;
-	}
+	if((glfwKey < 0) || (glfwKey > GLFW_KEY_LAST) || (keyActions[glfwKey] < 0) || (glfwAction == GLFW_REPEAT))
+		return;
+
+	int action = keyActions[glfwKey];
+	if(glfwAction == GLFW_PRESS)
+		latest |= bit(action);
 	else
+		latest &= ~bit(action);
+
+	if(numEvents == EVENT_CAPACITY)
 	{
-		return false;
+		eventsDropped = true;
+		return;
 	}
+
+	events[(firstEvent + numEvents) % EVENT_CAPACITY] = {(unsigned char)action, glfwAction == GLFW_PRESS};
+	numEvents++;
 }
 
-bool KeyboardInput::keyJustReleased(const char* keyName) const
+void KeyboardInput::update()
 {
-	auto it = keyNameMap.find(keyName);
-	if(it != keyNameMap.end())
+	justPressed = 0;
+	justReleased = 0;
+
+	for(; numEvents > 0; numEvents--)
 	{
-		const KeyStatus& status = keyStatusMap.at(it->second);
-		return !status.current && status.previous;
+		const KeyEvent& event = events[firstEvent];
+		firstEvent = (firstEvent + 1) % EVENT_CAPACITY;
+
+		if(event.pressed)
+		{
+			justPressed |= bit(event.action);
+			current |= bit(event.action);
+		}
+		else
+		{
+			justReleased |= bit(event.action);
+			current &= ~bit(event.action);
+		}
 	}
-	else
+
+	if(eventsDropped)
 	{
-		return false;
+		ActionMask previous = current;
+		current = latest;
+
+		justPressed |= current & ~previous;
+		justReleased |= previous & ~current;
+		eventsDropped = false;
 	}
 }
 
-bool KeyboardInput::keyReleased(const char* keyName) const
+bool KeyboardInput::keyJustPressed(int action) const
 {
-	auto it = keyNameMap.find(keyName);
-	if(it != keyNameMap.end())
-	{
-		const KeyStatus& status = keyStatusMap.at(it->second);
-		return !status.current;
-	}
-	else
-	{
-		return false;
-	}
+	return (justPressed & bit(action)) != 0;
+}
+
+bool KeyboardInput::keyPressed(int action) const
+{
+	return (current & bit(action)) != 0;
+}
+
+bool KeyboardInput::keyJustReleased(int action) const
+{
+	return (justReleased & bit(action)) != 0;
+}
+
+bool KeyboardInput::keyReleased(int action) const
+{
+	return (bound & ~current & bit(action)) != 0;
 }
 
 bool KeyboardInput::anyKeyJustPressed() const
 {
-	for(auto& [key, status] : keyStatusMap)
-	{
-		if(status.current && !status.previous) 
-			return true;
-	}
-	return false;
+	return justPressed != 0;
 }
 
 bool KeyboardInput::anyKeyPressed() const
 {
-	for(auto& [key, status] : keyStatusMap)
-	{
-		if(status.current)
-			return true;
-	}
-	return false;
+	return current != 0;
 }
 
 bool KeyboardInput::anyKeyJustReleased() const
 {
-	for(auto& [key, status] : keyStatusMap)
-	{
-		if(!status.current && status.previous)
-			return true;
-	}
-	return false;
+	return justReleased != 0;
 }
 
 bool KeyboardInput::anyKeyReleased() const
 {
-	for(auto& [key, status] : keyStatusMap)
-	{
-		if(!status.current)
-			return true;
-	}
-	return false;
+	return (bound & ~current) != 0;
 }
\ No newline at end of file
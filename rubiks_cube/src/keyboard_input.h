@@ -1,35 +1,62 @@
 #ifndef KEYBOARD_INPUT_H
 #define KEYBOARD_INPUT_H
 
-#include <unordered_map>
-
 #include <GLFW/glfw3.h>
 
+/*
+	Keys bound to actions, numbered by the user from 0 to MAX_ACTIONS - 1.
+	Key presses and releases come in through keyEvent(), called from the window's key callback, and wait in a ring
+	until update() applies them, so a step costs as much as the events it got and queries are bit tests.
+	A tap shorter than a step still counts as just pressed and just released.
+	Only the events are ever read, never the keyboard itself, so replayed events give the same state as the live ones
+	they were recorded from.
+*/
 class KeyboardInput
 {
+public :
+	static constexpr int
+		MAX_ACTIONS = 64,
+		EVENT_CAPACITY = 64;
+
 private :
-	struct KeyStatus
+	typedef unsigned long long ActionMask;
+
+	struct KeyEvent
 	{
-		bool previous;
-		bool current;
+		unsigned char action;
+		bool pressed;
 	};
 
-	std::unordered_map<const char*, int> keyNameMap;
-	std::unordered_map<int, KeyStatus> keyStatusMap;
-	GLFWwindow* window;
+	// -1 for unbound keys and actions
+	int keyActions[GLFW_KEY_LAST + 1];
+	int actionKeys[MAX_ACTIONS];
+
+	KeyEvent events[EVENT_CAPACITY];
+	int firstEvent, numEvents;
+
+	// Once events are dropped the state jumps to the latest one, which every event updates, dropped or not
+	bool eventsDropped;
+
+	ActionMask bound, current, justPressed, justReleased, latest;
+
+	static ActionMask bit(int action);
 
 public :
-	KeyboardInput(GLFWwindow* glfwWindow);
+	KeyboardInput();
+
+	// Fails for an action past MAX_ACTIONS or a key GLFW has no number for (GLFW_KEY_UNKNOWN)
+	bool setKeybind(int action, int glfwKey);
+	void removeKeybind(int action);
 
-	void setKeybind(const char* keyName, int glfwKey);
-	void removeKeybind(const char* keyName);
+	// With the key and action given to the window's key callback
+	void keyEvent(int glfwKey, int glfwAction);
 
 	void update();
 
-	bool keyJustPressed(const char* keyName) const;
-	bool keyPressed(const char* keyName) const;
-	bool keyJustReleased(const char* keyName) const;
-	bool keyReleased(const char* keyName) const;
+	bool keyJustPressed(int action) const;
+	bool keyPressed(int action) const;
+	bool keyJustReleased(int action) const;
+	bool keyReleased(int action) const;
 
 	bool anyKeyJustPressed() const;
 	bool anyKeyPressed() const;
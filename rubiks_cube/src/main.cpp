@@ -1,8 +1,144 @@
 #include "application.h"
+#include "trace.h"
 
-int main()
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char** argv)
 {
-	Application app{};
+	// rubiks_cube [--size <N>] [--wall <count>] [--shaders <directory>] [--record <file> | --replay <file>] [--profile <file>] [--trace <file>] ...
+	int cubeSize = RubiksCube::DEFAULT_SIZE;
+	int wallCubes = 1;
+	const char* shaderDirectory = nullptr;
+	const char* recordPath = nullptr;
+	const char* profilePath = nullptr;
+	const char* tracePath = nullptr;
+	InputLog replayLog;
+	bool replaying = false;
+	while(argc >= 3)
+	{
+		if(strcmp(argv[1], "--size") == 0)
+		{
+			cubeSize = atoi(argv[2]);
+			if((cubeSize < 1) || (cubeSize > RubiksCube::MAX_SIZE))
+			{
+				printf("Invalid cube size : %s (1 to %d)\n", argv[2], RubiksCube::MAX_SIZE);
+				return 1;
+			}
+		}
+		else if(strcmp(argv[1], "--wall") == 0)
+		{
+			wallCubes = atoi(argv[2]);
+			if((wallCubes < 1) || (wallCubes > Application::MAX_WALL_CUBES))
+			{
+				printf("Invalid wall size : %s (1 to %d)\n", argv[2], Application::MAX_WALL_CUBES);
+				return 1;
+			}
+		}
+		else if(strcmp(argv[1], "--shaders") == 0)
+		{
+			shaderDirectory = argv[2];
+		}
+		else if(strcmp(argv[1], "--record") == 0)
+		{
+			recordPath = argv[2];
+		}
+		else if(strcmp(argv[1], "--profile") == 0)
+		{
+			profilePath = argv[2];
+		}
+		else if(strcmp(argv[1], "--trace") == 0)
+		{
+			tracePath = argv[2];
+		}
+		else if(strcmp(argv[1], "--replay") == 0)
+		{
+			if(!replayLog.load(argv[2]))
+				return 1;
+
+			replaying = true;
+		}
+		else
+		{
+			break;
+		}
+
+		argc -= 2;
+		argv += 2;
+	}
+
+	// A replay brings its own cubes
+	if(replaying)
+	{
+		cubeSize = replayLog.cubeSize;
+		wallCubes = replayLog.wallCubes;
+
+		if((cubeSize < 1) || (cubeSize > RubiksCube::MAX_SIZE) || (wallCubes < 1) || (wallCubes > Application::MAX_WALL_CUBES))
+		{
+			printf("Invalid input log cubes : --size %d --wall %d\n", cubeSize, wallCubes);
+			return 1;
+		}
+	}
+
+	if((long long)wallCubes * RubiksCube::numSurfaceCubies(cubeSize) > Application::MAX_WALL_CUBIES)
+	{
+		printf("Wall too large : %d cubes of %d cubies (at most %d cubies)\n",
+			   wallCubes, RubiksCube::numSurfaceCubies(cubeSize), Application::MAX_WALL_CUBIES);
+		return 1;
+	}
+
+	// From the start, so loading the shaders shows up too
+	if(tracePath)
+	{
+		trace::enable(true);
+		trace::setThreadName("main");
+	}
+
+	// rubiks_cube --render <scrambles file> <output directory> [image size]
+	if((argc >= 4) && (strcmp(argv[1], "--render") == 0))
+	{
+		int imageSize = (argc >= 5) ? atoi(argv[4]) : 256;
+		if(imageSize <= 0)
+		{
+			printf("Invalid image size : %s\n", argv[4]);
+			return 1;
+		}
+
+		Application app{imageSize, imageSize, true, cubeSize, 1, shaderDirectory};
+		bool success = app.renderScrambles(argv[2], argv[3]);
+
+		if(tracePath)
+			success &= trace::save(tracePath);
+
+		return success ? 0 : 1;
+	}
+
+#ifdef GLEW_OSMESA
+	printf("This build only renders offscreen : rubiks_cube --render <scrambles file> <output directory> [image size]\n");
+	return 1;
+#else
+	Application app{1280, 720, false, cubeSize, wallCubes, shaderDirectory};
+
+	if(replaying)
+	{
+		if(!app.replay(replayLog))
+			return 1;
+	}
+	else if(recordPath)
+	{
+		app.record(recordPath);
+	}
+
+	if(profilePath)
+		app.profile(profilePath);
+
 	app.run();
+
+	// The render thread is done by now
+	if(tracePath && !trace::save(tracePath))
+		return 1;
+
 	return 0;
+#endif
 }
\ No newline at end of file
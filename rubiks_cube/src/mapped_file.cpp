@@ -0,0 +1,183 @@
+#include "mapped_file.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	mapping{nullptr}, mappingSize{0}
+#ifdef _WIN32
+	, fileHandle{INVALID_HANDLE_VALUE}, mappingHandle{nullptr}
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+bool MappedFile::open(const char* path)
+{
+	close();
+
+#ifdef _WIN32
+
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if(fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if(!GetFileSizeEx(fileHandle, &fileSize) || (fileSize.QuadPart == 0))
+	{
+		close();
+		return false;
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(!mappingHandle)
+	{
+		close();
+		return false;
+	}
+
+	mapping = (const unsigned char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	mappingSize = (size_t)fileSize.QuadPart;
+
+#else
+
+	int fd = ::open(path, O_RDONLY);
+	if(fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if((fstat(fd, &fileStat) != 0) || (fileStat.st_size == 0))
+	{
+		::close(fd);
+		return false;
+	}
+
+	void* address = mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if(address == MAP_FAILED)
+		return false;
+
+	mapping = (const unsigned char*)address;
+	mappingSize = (size_t)fileStat.st_size;
+
+#endif
+
+	if(!mapping)
+	{
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+
+	if(mapping)
+		UnmapViewOfFile(mapping);
+	if(mappingHandle)
+		CloseHandle(mappingHandle);
+	if(fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+
+#else
+
+	if(mapping)
+		munmap((void*)mapping, mappingSize);
+
+#endif
+
+	mapping = nullptr;
+	mappingSize = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+	return mapping != nullptr;
+}
+
+const unsigned char* MappedFile::data() const
+{
+	return mapping;
+}
+
+size_t MappedFile::size() const
+{
+	return mappingSize;
+}
+
+namespace
+{
+	// Unique to this write, even with other processes or threads writing the same path at once
+	std::string uniqueTemporaryPath(const char* path)
+	{
+		static std::atomic<unsigned int> counter{0};
+
+#ifdef _WIN32
+		unsigned long processId = GetCurrentProcessId();
+#else
+		unsigned long processId = (unsigned long)getpid();
+#endif
+
+		return std::string{path} + "." + std::to_string(processId) + "." + std::to_string(counter.fetch_add(1)) + ".tmp";
+	}
+}
+
+bool MappedFile::write(const char* path, const void* data, size_t size)
+{
+	std::string temporaryPath = uniqueTemporaryPath(path);
+
+	// Exclusively, never into a file someone else is writing
+	FILE* file = fopen(temporaryPath.c_str(), "wbx");
+	if(!file)
+	{
+		printf("Failed to open %s for writing\n", temporaryPath.c_str());
+		return false;
+	}
+
+	bool written = (fwrite(data, 1, size, file) == size);
+	written = (fclose(file) == 0) && written;
+
+	if(!written)
+	{
+		printf("Failed to write %s\n", temporaryPath.c_str());
+		remove(temporaryPath.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	bool renamed = MoveFileExA(temporaryPath.c_str(), path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	bool renamed = rename(temporaryPath.c_str(), path) == 0;
+#endif
+
+	if(!renamed)
+	{
+		printf("Failed to move %s into place\n", temporaryPath.c_str());
+		remove(temporaryPath.c_str());
+		return false;
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+private :
+	const unsigned char* mapping;
+	size_t mappingSize;
+
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+
+public :
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const;
+	const unsigned char* data() const;
+	size_t size() const;
+
+	// Writes to a temporary file of its own first and renames it, so readers never map a partially written file, even
+	// with several processes writing the same path
+	static bool write(const char* path, const void* data, size_t size);
+};
+
+#endif
\ No newline at end of file
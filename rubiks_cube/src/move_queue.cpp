@@ -0,0 +1,131 @@
+#include "move_queue.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	constexpr int CLOCK_CHECK_INTERVAL = 256;
+}
+
+MoveQueue::MoveQueue(RubiksCube& cube) :
+	cube{cube}, moves{},
+	animating{false}, animatedMove{MOVE_R, 0}, animatedFraction{0.0f},
+	movesPerSecond{DEFAULT_MOVES_PER_SECOND}, maxAnimatedMoves{DEFAULT_MAX_ANIMATED_MOVES},
+	fastForwardBudgetSeconds{DEFAULT_FAST_FORWARD_BUDGET_SECONDS}
+{}
+
+void MoveQueue::push(LayerMove move)
+{
+	moves.push_back(move);
+}
+
+void MoveQueue::push(Move move)
+{
+	moves.push_back({move, 0});
+}
+
+void MoveQueue::push(const MoveSequence& sequence)
+{
+	for(Move move : sequence)
+		moves.push_back({move, 0});
+}
+
+void MoveQueue::push(const std::vector<LayerMove>& moves)
+{
+	this->moves.insert(this->moves.end(), moves.begin(), moves.end());
+}
+
+void MoveQueue::clear()
+{
+	moves.clear();
+
+	if(animating)
+	{
+		cube.applyMove(animatedMove);
+		animating = false;
+	}
+}
+
+void MoveQueue::setMovesPerSecond(float movesPerSecond)
+{
+	this->movesPerSecond = movesPerSecond;
+}
+
+void MoveQueue::setMaxAnimatedMoves(size_t maxAnimatedMoves)
+{
+	this->maxAnimatedMoves = maxAnimatedMoves;
+}
+
+void MoveQueue::setFastForwardBudget(float seconds)
+{
+	fastForwardBudgetSeconds = seconds;
+}
+
+bool MoveQueue::isIdle() const
+{
+	return !animating && moves.empty();
+}
+
+size_t MoveQueue::size() const
+{
+	return moves.size() + (animating ? 1 : 0);
+}
+
+void MoveQueue::fastForward()
+{
+	if(animating)
+	{
+		cube.applyMove(animatedMove);
+		animating = false;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<float>{fastForwardBudgetSeconds});
+
+	for(int applied = 1; moves.size() > maxAnimatedMoves; applied++)
+	{
+		cube.applyMove(moves.front());
+		moves.pop_front();
+
+		if((fastForwardBudgetSeconds > 0.0f) && (applied % CLOCK_CHECK_INTERVAL == 0) && (std::chrono::steady_clock::now() > deadline))
+			break;
+	}
+}
+
+void MoveQueue::update(float deltaTime)
+{
+	if(moves.size() > maxAnimatedMoves)
+		fastForward();
+
+	// Leftover time from a finished move carries into the next one
+	float remaining = deltaTime * movesPerSecond;
+
+	while(remaining > 0.0f)
+	{
+		if(!animating)
+		{
+			if(moves.empty())
+				break;
+
+			animatedMove = moves.front();
+			moves.pop_front();
+			animatedFraction = 0.0f;
+			animating = true;
+		}
+
+		float step = std::min(remaining, 1.0f - animatedFraction);
+		animatedFraction += step;
+		remaining -= step;
+
+		if(animatedFraction >= 1.0f)
+		{
+			cube.applyMove(animatedMove);
+			animating = false;
+		}
+		else
+		{
+			cube.animateMove(animatedMove, animatedFraction);
+		}
+	}
+}
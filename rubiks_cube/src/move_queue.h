@@ -0,0 +1,58 @@
+#ifndef MOVE_QUEUE_H
+#define MOVE_QUEUE_H
+
+#include "rubiks_cube.h"
+
+#include <deque>
+
+/*
+	Plays queued moves on a RubiksCube, animating each one at a fixed rate.
+	Once more than maxAnimatedMoves are waiting, the excess is applied instantly (only the logical move and the
+	snapped transforms) within a per-frame time budget, so long sequences only animate their tail.
+*/
+class MoveQueue
+{
+public :
+	static constexpr float
+		DEFAULT_MOVES_PER_SECOND = 3.0f,
+		DEFAULT_FAST_FORWARD_BUDGET_SECONDS = 0.004f;
+
+	static constexpr size_t DEFAULT_MAX_ANIMATED_MOVES = 30;
+
+private :
+	RubiksCube& cube;
+	std::deque<LayerMove> moves;
+
+	bool animating;
+	LayerMove animatedMove;
+	float animatedFraction;
+
+	float movesPerSecond;
+	size_t maxAnimatedMoves;
+	float fastForwardBudgetSeconds;
+
+	void fastForward();
+
+public :
+	MoveQueue(RubiksCube& cube);
+
+	void push(LayerMove move);
+	void push(Move move);
+	void push(const MoveSequence& sequence);
+	void push(const std::vector<LayerMove>& moves);
+
+	// Drops the waiting moves, a move already being animated is completed
+	void clear();
+
+	void setMovesPerSecond(float movesPerSecond);
+	void setMaxAnimatedMoves(size_t maxAnimatedMoves);
+	// 0 for no budget, the excess is then applied in one update whatever the clock says
+	void setFastForwardBudget(float seconds);
+
+	bool isIdle() const;
+	size_t size() const;
+
+	void update(float deltaTime);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "move_sequence.h"
+
+MoveSequence::MoveSequence() :
+	moves{}
+{}
+
+MoveSequence::MoveSequence(const Move* moves, size_t numMoves) :
+	moves{moves, moves + numMoves}
+{}
+
+void MoveSequence::push(Move move)
+{
+	moves.push_back(move);
+}
+
+void MoveSequence::append(const Move* moves, size_t numMoves)
+{
+	this->moves.insert(this->moves.end(), moves, moves + numMoves);
+}
+
+void MoveSequence::assign(const Move* moves, size_t numMoves)
+{
+	this->moves.assign(moves, moves + numMoves);
+}
+
+void MoveSequence::reserve(size_t capacity)
+{
+	moves.reserve(capacity);
+}
+
+void MoveSequence::clear()
+{
+	moves.clear();
+}
+
+size_t MoveSequence::size() const
+{
+	return moves.size();
+}
+
+bool MoveSequence::empty() const
+{
+	return moves.empty();
+}
+
+const Move* MoveSequence::data() const
+{
+	return moves.data();
+}
+
+const Move* MoveSequence::begin() const
+{
+	return moves.data();
+}
+
+const Move* MoveSequence::end() const
+{
+	return moves.data() + moves.size();
+}
+
+Move MoveSequence::operator[](size_t index) const
+{
+	return moves[index];
+}
+
+MoveSequence MoveSequence::inverse() const
+{
+	MoveSequence inverse;
+	inverse.reserve(moves.size());
+
+	for(size_t i = moves.size(); i > 0; i--)
+		inverse.push(inverseMove(moves[i - 1]));
+	return inverse;
+}
+
+bool MoveSequence::operator==(const MoveSequence& other) const
+{
+	return moves == other.moves;
+}
@@ -0,0 +1,35 @@
+#ifndef MOVE_SEQUENCE_H
+#define MOVE_SEQUENCE_H
+
+#include "cube_state.h"
+
+#include <vector>
+
+// Moves stored one byte each. clear() keeps the storage, so a reused sequence stops allocating
+class MoveSequence
+{
+private :
+	std::vector<Move> moves;
+
+public :
+	MoveSequence();
+	MoveSequence(const Move* moves, size_t numMoves);
+
+	void push(Move move);
+	void append(const Move* moves, size_t numMoves);
+	void assign(const Move* moves, size_t numMoves);
+	void reserve(size_t capacity);
+	void clear();
+
+	size_t size() const;
+	bool empty() const;
+	const Move* data() const;
+	const Move* begin() const;
+	const Move* end() const;
+	Move operator[](size_t index) const;
+
+	MoveSequence inverse() const;
+	bool operator==(const MoveSequence& other) const;
+};
+
+#endif
@@ -0,0 +1,234 @@
+#include "notation.h"
+
+#include <array>
+#include <cstring>
+
+namespace
+{
+	constexpr unsigned char DIGIT = 0xFD, SEPARATOR = 0xFE, INVALID = 0xFF;
+
+	// Moves are collected on the stack and appended in blocks, so parsing never allocates per token
+	constexpr size_t BLOCK_SIZE = 256;
+
+	constexpr std::array<unsigned char, 256> buildCharacterFamilies()
+	{
+		std::array<unsigned char, 256> families{};
+		for(unsigned char& family : families)
+			family = INVALID;
+
+		const char faces[] = "RLUDFB";
+		const char wideFaces[] = "rludfb";
+		for(int face = 0; face < 6; face++)
+		{
+			families[(unsigned char)faces[face]] = (unsigned char)(FAMILY_FACE + face);
+			families[(unsigned char)wideFaces[face]] = (unsigned char)(FAMILY_WIDE + face);
+		}
+
+		const char slices[] = "MES";
+		const char rotations[] = "xyz";
+		const char upperRotations[] = "XYZ";
+		for(int axis = 0; axis < 3; axis++)
+		{
+			families[(unsigned char)slices[axis]] = (unsigned char)(FAMILY_SLICE + axis);
+			families[(unsigned char)rotations[axis]] = (unsigned char)(FAMILY_ROTATION + axis);
+			families[(unsigned char)upperRotations[axis]] = (unsigned char)(FAMILY_ROTATION + axis);
+		}
+
+		for(char separator : {' ', '\t', '\r', '\n'})
+			families[(unsigned char)separator] = SEPARATOR;
+
+		for(char digit = '0'; digit <= '9'; digit++)
+			families[(unsigned char)digit] = DIGIT;
+
+		return families;
+	}
+
+	constexpr std::array<unsigned char, 256> CHARACTER_FAMILIES = buildCharacterFamilies();
+
+	constexpr const char* FAMILY_NAMES[NUM_MOVE_FAMILIES]
+	{
+		"R", "L", "U", "D", "F", "B",
+		"M", "E", "S",
+		"Rw", "Lw", "Uw", "Dw", "Fw", "Bw",
+		"x", "y", "z"
+	};
+
+	constexpr const char* TURN_SUFFIXES[NUM_TURNS] = {"", "2", "'"};
+
+	struct MoveName
+	{
+		char text[4];
+	};
+
+	std::array<MoveName, NUM_MOVES> buildMoveNames()
+	{
+		std::array<MoveName, NUM_MOVES> names{};
+
+		for(int move = 0; move < NUM_MOVES; move++)
+		{
+			std::strcpy(names[move].text, FAMILY_NAMES[moveFace((Move)move)]);
+			std::strcat(names[move].text, TURN_SUFFIXES[moveTurn((Move)move)]);
+		}
+
+		return names;
+	}
+
+	const std::array<MoveName, NUM_MOVES> MOVE_NAMES = buildMoveNames();
+
+	inline bool makeMove(Move move, unsigned int depth, Move& element)
+	{
+		element = move;
+		return depth == 0;
+	}
+
+	inline bool makeMove(Move move, unsigned int depth, LayerMove& element)
+	{
+		element = {move, (unsigned char)depth};
+		return true;
+	}
+
+	/*
+		Shared by both parse overloads. Element is Move or LayerMove, only the latter takes depth prefixes (3R, 3Rw),
+		append(block, count) adds parsed moves to the output
+	*/
+	template<typename Element, typename Append>
+	bool parseMoves(const char* text, size_t length, size_t* errorOffset, Append append)
+	{
+		Element block[BLOCK_SIZE];
+		size_t numBlocked = 0;
+
+		const unsigned char* cursor = (const unsigned char*)text;
+		const unsigned char* end = cursor + length;
+
+		auto fail = [&](const unsigned char* token)
+		{
+			append(block, numBlocked);
+			if(errorOffset)
+				*errorOffset = (size_t)(token - (const unsigned char*)text);
+			return false;
+		};
+
+		while(cursor < end)
+		{
+			const unsigned char* token = cursor;
+			unsigned char family = CHARACTER_FAMILIES[*cursor];
+
+			if(family == SEPARATOR)
+			{
+				cursor++;
+				continue;
+			}
+
+			// Only face and wide turns have a depth, from 1 to 255
+			unsigned int depth = 0;
+			if(family == DIGIT)
+			{
+				while((cursor < end) && (CHARACTER_FAMILIES[*cursor] == DIGIT) && (depth <= 255))
+					depth = depth * 10 + (*cursor++ - '0');
+
+				family = (cursor < end) ? CHARACTER_FAMILIES[*cursor] : INVALID;
+				bool faceOrWide = (family < FAMILY_SLICE) || ((family >= FAMILY_WIDE) && (family < FAMILY_ROTATION));
+				if((depth == 0) || (depth > 255) || !faceOrWide)
+					return fail(token);
+			}
+
+			if(family == INVALID)
+				return fail(token);
+
+			cursor++;
+
+			// Suffixes in order : w (face turns only), 2, ' and R2' is still a half turn.
+			// Worked out with arithmetic on the suffix flags rather than branches
+			auto next = [&cursor, end]() { return (cursor < end) ? *cursor : (unsigned char)0; };
+
+			int wide = (next() == 'w') & (family < FAMILY_SLICE);
+			family += (unsigned char)(wide * FAMILY_WIDE);
+			cursor += wide;
+
+			int isDouble = (next() == '2');
+			cursor += isDouble;
+
+			int isPrime = (next() == '\'');
+			cursor += isPrime;
+
+			// A prime only counts without a 2
+			int turn = isDouble * TURN_DOUBLE + (isPrime & (isDouble ^ 1)) * TURN_COUNTER_CLOCKWISE;
+
+			if(!makeMove((Move)(family * NUM_TURNS + turn), depth, block[numBlocked]))
+				return fail(token);
+
+			if(++numBlocked == BLOCK_SIZE)
+			{
+				append(block, numBlocked);
+				numBlocked = 0;
+			}
+		}
+
+		append(block, numBlocked);
+		return true;
+	}
+}
+
+bool notation::parse(const char* text, size_t length, MoveSequence& sequence, size_t* errorOffset)
+{
+	sequence.clear();
+
+	return parseMoves<Move>(text, length, errorOffset, [&sequence](const Move* moves, size_t numMoves)
+	{
+		sequence.append(moves, numMoves);
+	});
+}
+
+bool notation::parse(const char* text, size_t length, std::vector<LayerMove>& moves, size_t* errorOffset)
+{
+	moves.clear();
+
+	return parseMoves<LayerMove>(text, length, errorOffset, [&moves](const LayerMove* parsed, size_t numParsed)
+	{
+		moves.insert(moves.end(), parsed, parsed + numParsed);
+	});
+}
+
+bool notation::parse(const char* text, MoveSequence& sequence, size_t* errorOffset)
+{
+	return parse(text, std::strlen(text), sequence, errorOffset);
+}
+
+const char* notation::moveName(Move move)
+{
+	return MOVE_NAMES[move].text;
+}
+
+void notation::format(const Move* moves, size_t numMoves, std::string& text)
+{
+	for(size_t i = 0; i < numMoves; i++)
+	{
+		if(!text.empty())
+			text += ' ';
+		text += MOVE_NAMES[moves[i]].text;
+	}
+}
+
+void notation::format(const LayerMove* moves, size_t numMoves, std::string& text)
+{
+	for(size_t i = 0; i < numMoves; i++)
+	{
+		if(!text.empty())
+			text += ' ';
+
+		// Slices and rotations ignore the depth, so it is left out as parsing would refuse it
+		int family = moveFace(moves[i].move);
+		bool faceOrWide = (family < FAMILY_SLICE) || ((family >= FAMILY_WIDE) && (family < FAMILY_ROTATION));
+		if((moves[i].depth != 0) && faceOrWide)
+			text += std::to_string(moves[i].depth);
+
+		text += MOVE_NAMES[moves[i].move].text;
+	}
+}
+
+std::string notation::format(const MoveSequence& sequence)
+{
+	std::string text;
+	format(sequence.data(), sequence.size(), text);
+	return text;
+}
@@ -0,0 +1,32 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include "move_sequence.h"
+
+#include <string>
+#include <vector>
+
+// Singmaster notation : R U' F2, wide turns as Rw or r, slices M E S and rotations x y z.
+// Big cube moves take a depth : 3R turns the third layer from R, 3Rw (or 3r) the three outer layers
+namespace notation
+{
+	/*
+		Parses moves separated by whitespace or written together ("RUR'U'") into sequence, replacing its contents.
+		On an unknown token returns false with its byte offset in errorOffset, sequence then holds the moves before it.
+	*/
+	bool parse(const char* text, size_t length, MoveSequence& sequence, size_t* errorOffset = nullptr);
+	bool parse(const char* text, MoveSequence& sequence, size_t* errorOffset = nullptr);
+
+	// As above, also taking depths, which a MoveSequence can't hold
+	bool parse(const char* text, size_t length, std::vector<LayerMove>& moves, size_t* errorOffset = nullptr);
+
+	const char* moveName(Move move);
+
+	// Appends the moves to text, separated by spaces
+	void format(const Move* moves, size_t numMoves, std::string& text);
+	// As above, writing depths as prefixes (3R, 3Rw)
+	void format(const LayerMove* moves, size_t numMoves, std::string& text);
+	std::string format(const MoveSequence& sequence);
+}
+
+#endif
@@ -0,0 +1,686 @@
+#include "optimal_solver.h"
+#include "cube_coordinates.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	constexpr char TABLE_MAGIC[8] = {'R', 'C', 'O', 'P', 'T', 'I', 'M', 'L'};
+	constexpr size_t HEADER_SIZE = 16;
+
+	// Magic, then the version of the tables' layout and generation, bumped whenever either changes, then the
+	// coordinates' fingerprint
+	constexpr unsigned int TABLE_VERSION = 2;
+
+	void writeHeader(unsigned char* data)
+	{
+		unsigned int version[2] = {TABLE_VERSION, coordinates::fingerprint()};
+		std::memcpy(data, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+		std::memcpy(data + sizeof(TABLE_MAGIC), version, sizeof(version));
+	}
+
+	bool isCurrentHeader(const unsigned char* data)
+	{
+		unsigned char header[HEADER_SIZE];
+		writeHeader(header);
+		return std::memcmp(data, header, HEADER_SIZE) == 0;
+	}
+
+	constexpr unsigned char UNVISITED = 0xFF;
+	constexpr int STOP_CHECK_INTERVAL = 4096;
+	constexpr int NUM_TASK_PLIES = 2;
+
+	constexpr int
+		EDGES_PER_SET = CubeState::NUM_EDGES / OptimalSolver::NUM_EDGE_SETS,
+		NUM_EDGE_ARRANGEMENTS = 12 * 11 * 10 * 9 * 8 * 7,
+		NUM_EDGE_SET_ORIENTATIONS = 1 << EDGES_PER_SET;
+
+	constexpr size_t
+		NUM_CORNER_PATTERNS = (size_t)coordinates::NUM_CORNER_PERMUTATIONS * coordinates::NUM_TWISTS,
+		NUM_EDGE_PATTERNS = (size_t)NUM_EDGE_ARRANGEMENTS * NUM_EDGE_SET_ORIENTATIONS;
+
+	struct TableLayout
+	{
+		size_t cornerPermutationMove, twistMove;
+		size_t cornerPrune, edgePrune[OptimalSolver::NUM_EDGE_SETS];
+		size_t size;
+	};
+
+	constexpr TableLayout computeLayout()
+	{
+		using namespace coordinates;
+
+		TableLayout layout{};
+		size_t offset = HEADER_SIZE;
+
+		auto allocate = [&offset](size_t size)
+		{
+			size_t start = offset;
+			offset += (size + 7) & ~(size_t)7;
+			return start;
+		};
+
+		layout.cornerPermutationMove = allocate((size_t)NUM_CORNER_PERMUTATIONS * NUM_FACE_MOVES * sizeof(unsigned short));
+		layout.twistMove = allocate((size_t)NUM_TWISTS * NUM_FACE_MOVES * sizeof(unsigned short));
+		layout.cornerPrune = allocate((NUM_CORNER_PATTERNS + 1) / 2);
+		for(size_t& edgePrune : layout.edgePrune)
+			edgePrune = allocate((NUM_EDGE_PATTERNS + 1) / 2);
+		layout.size = offset;
+
+		return layout;
+	}
+
+	constexpr TableLayout LAYOUT = computeLayout();
+
+	// Edges are tracked as (slot * 2 + orientation), this maps that through every move
+	struct EdgeMoveTable
+	{
+		unsigned char target[NUM_FACE_MOVES][CubeState::NUM_EDGES * 2];
+	};
+
+	EdgeMoveTable buildEdgeMoveTable()
+	{
+		EdgeMoveTable table{};
+
+		for(int move = 0; move < NUM_FACE_MOVES; move++)
+		{
+			CubeState state;
+			state.applyMove((Move)move);
+
+			for(int slot = 0; slot < CubeState::NUM_EDGES; slot++)
+			{
+				int source = state.edgePermutation[slot];
+				for(int orientation = 0; orientation < 2; orientation++)
+					table.target[move][source * 2 + orientation] = (unsigned char)(slot * 2 + (orientation ^ state.edgeOrientation[slot]));
+			}
+		}
+
+		return table;
+	}
+
+	const EdgeMoveTable EDGE_MOVES = buildEdgeMoveTable();
+
+	// Ordered slots of the six edges of a set (12! / 6! arrangements) followed by their six orientation bits
+	inline int edgePatternIndex(const unsigned char* edges)
+	{
+		int arrangement = 0, orientation = 0;
+		unsigned int usedSlots = 0;
+
+		for(int i = 0; i < EDGES_PER_SET; i++)
+		{
+			int slot = edges[i] >> 1;
+			arrangement = arrangement * (CubeState::NUM_EDGES - i) + slot - std::popcount(usedSlots & ((1u << slot) - 1));
+			usedSlots |= 1u << slot;
+			orientation = orientation * 2 + (edges[i] & 1);
+		}
+
+		return arrangement * NUM_EDGE_SET_ORIENTATIONS + orientation;
+	}
+
+	void setEdgePatternIndex(unsigned char* edges, int index)
+	{
+		int orientation = index % NUM_EDGE_SET_ORIENTATIONS;
+		int arrangement = index / NUM_EDGE_SET_ORIENTATIONS;
+
+		int digits[EDGES_PER_SET];
+		for(int i = EDGES_PER_SET - 1; i >= 0; i--)
+		{
+			digits[i] = arrangement % (CubeState::NUM_EDGES - i);
+			arrangement /= (CubeState::NUM_EDGES - i);
+		}
+
+		unsigned int usedSlots = 0;
+		for(int i = 0; i < EDGES_PER_SET; i++)
+		{
+			int slot = 0;
+			for(int skipped = 0; ; slot++)
+			{
+				if(usedSlots & (1u << slot))
+					continue;
+				if(skipped == digits[i])
+					break;
+				skipped++;
+			}
+
+			usedSlots |= 1u << slot;
+			edges[i] = (unsigned char)(slot * 2 + ((orientation >> (EDGES_PER_SET - 1 - i)) & 1));
+		}
+	}
+
+	inline int prunedDistance(const unsigned char* prune, size_t index)
+	{
+		return (prune[index / 2] >> ((index % 2) * 4)) & 0xF;
+	}
+
+	int defaultThreadCount()
+	{
+		return std::max((int)std::thread::hardware_concurrency(), 1);
+	}
+
+	// Splits [0, count) into one contiguous range per thread and sums what each range returns
+	template<typename Function>
+	size_t parallelSum(size_t count, int numThreads, Function function)
+	{
+		std::vector<size_t> sums(numThreads, 0);
+		std::vector<std::thread> threads;
+
+		for(int i = 0; i < numThreads; i++)
+		{
+			size_t begin = count * i / numThreads, end = count * (i + 1) / numThreads;
+			threads.emplace_back([&function, &sums, i, begin, end]() { sums[i] = function(begin, end); });
+		}
+
+		size_t sum = 0;
+		for(int i = 0; i < numThreads; i++)
+		{
+			threads[i].join();
+			sum += sums[i];
+		}
+		return sum;
+	}
+
+	/*
+		Breadth-first distances from the solved pattern, packed into 4 bits each.
+		A level is expanded forwards from its own patterns until half of all patterns are reached,
+		after that it is cheaper to let every unvisited pattern look for a neighbour on the level.
+	*/
+	template<typename Neighbours>
+	void buildPatternDatabase(unsigned char* prune, size_t numPatterns, size_t solvedPattern, Neighbours getNeighbours)
+	{
+		std::vector<unsigned char> distances(numPatterns, UNVISITED);
+		distances[solvedPattern] = 0;
+
+		size_t numVisited = 1;
+		for(unsigned char depth = 0; numVisited < numPatterns; depth++)
+		{
+			bool backwards = numVisited > numPatterns / 2;
+
+			size_t numFound = parallelSum(numPatterns, defaultThreadCount(), [&](size_t begin, size_t end)
+			{
+				size_t found = 0, neighbours[NUM_FACE_MOVES];
+
+				for(size_t index = begin; index < end; index++)
+				{
+					std::atomic_ref<unsigned char> distance{distances[index]};
+
+					if(backwards)
+					{
+						if(distance.load(std::memory_order_relaxed) != UNVISITED)
+							continue;
+
+						getNeighbours(index, neighbours);
+						for(size_t neighbour : neighbours)
+						{
+							if(std::atomic_ref<unsigned char>{distances[neighbour]}.load(std::memory_order_relaxed) == depth)
+							{
+								distance.store(depth + 1, std::memory_order_relaxed);
+								found++;
+								break;
+							}
+						}
+					}
+					else
+					{
+						if(distance.load(std::memory_order_relaxed) != depth)
+							continue;
+
+						getNeighbours(index, neighbours);
+						for(size_t neighbour : neighbours)
+						{
+							unsigned char expected = UNVISITED;
+							if(std::atomic_ref<unsigned char>{distances[neighbour]}.compare_exchange_strong(
+								expected, (unsigned char)(depth + 1), std::memory_order_relaxed))
+							{
+								found++;
+							}
+						}
+					}
+				}
+
+				return found;
+			});
+
+			if(numFound == 0)
+				break;
+			numVisited += numFound;
+		}
+
+		std::fill(prune, prune + (numPatterns + 1) / 2, 0);
+		for(size_t index = 0; index < numPatterns; index++)
+			prune[index / 2] |= (unsigned char)(distances[index] << ((index % 2) * 4));
+	}
+}
+
+struct OptimalSolver::Node
+{
+	unsigned short cornerPermutation, twist;
+	unsigned char edges[NUM_EDGE_SETS][EDGES_PER_SET];
+};
+
+struct OptimalSolver::Worker
+{
+	struct Task
+	{
+		Move moves[NUM_TASK_PLIES];
+	};
+
+	Search& search;
+	int index;
+
+	std::mutex queueMutex;
+	std::deque<Task> tasks;
+
+	Move path[MAX_SOLUTION_LENGTH];
+	long long nodes;
+
+	Worker(Search& search, int index) :
+		search{search}, index{index}, queueMutex{}, tasks{}, path{}, nodes{0}
+	{}
+
+	void run();
+	bool takeTask(Task& task);
+	bool stealTask(Task& task);
+	bool searchFrom(const Node& node, int depth, int remaining, int lastFace);
+};
+
+struct OptimalSolver::Search
+{
+	OptimalSolver& solver;
+	Node root;
+	int bound;
+
+	bool hasDeadline;
+	std::chrono::steady_clock::time_point deadline;
+
+	std::atomic<bool> stopped = false;
+	bool found = false;
+	std::mutex solutionMutex = {};
+	Move solution[MAX_SOLUTION_LENGTH] = {};
+
+	std::deque<Worker> workers = {};
+
+	void checkStop()
+	{
+		if(solver.cancelled.load(std::memory_order_relaxed) || (hasDeadline && (std::chrono::steady_clock::now() > deadline)))
+			stopped.store(true, std::memory_order_relaxed);
+	}
+
+	void submit(const Move* path)
+	{
+		std::lock_guard<std::mutex> lock{solutionMutex};
+		if(!found)
+		{
+			found = true;
+			std::copy(path, path + bound, solution);
+		}
+		stopped.store(true, std::memory_order_relaxed);
+	}
+};
+
+bool OptimalSolver::Worker::takeTask(Task& task)
+{
+	std::lock_guard<std::mutex> lock{queueMutex};
+	if(tasks.empty())
+		return false;
+
+	task = tasks.front();
+	tasks.pop_front();
+	return true;
+}
+
+// Thieves take from the back, away from where the owner is working
+bool OptimalSolver::Worker::stealTask(Task& task)
+{
+	for(size_t i = 1; i < search.workers.size(); i++)
+	{
+		Worker& victim = search.workers[(index + i) % search.workers.size()];
+
+		std::lock_guard<std::mutex> lock{victim.queueMutex};
+		if(!victim.tasks.empty())
+		{
+			task = victim.tasks.back();
+			victim.tasks.pop_back();
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void OptimalSolver::Worker::run()
+{
+	trace::setThreadName("optimal solver worker");
+	trace::Zone zone{"optimal worker"};
+
+	Task task;
+	while(!search.stopped.load(std::memory_order_relaxed) && (takeTask(task) || stealTask(task)))
+	{
+		Node node = search.root;
+		for(int i = 0; i < NUM_TASK_PLIES; i++)
+		{
+			node = search.solver.applyMove(node, task.moves[i]);
+			path[i] = task.moves[i];
+		}
+		nodes += NUM_TASK_PLIES;
+
+		if(search.solver.heuristic(node, search.bound - NUM_TASK_PLIES) > search.bound - NUM_TASK_PLIES)
+			continue;
+
+		if(searchFrom(node, NUM_TASK_PLIES, search.bound - NUM_TASK_PLIES, moveFace(task.moves[NUM_TASK_PLIES - 1])))
+			search.submit(path);
+	}
+}
+
+bool OptimalSolver::Worker::searchFrom(const Node& node, int depth, int remaining, int lastFace)
+{
+	// Only entered with heuristic <= remaining, and the heuristic is 0 only for the solved cube
+	if(remaining == 0)
+		return true;
+
+	for(int i = 0; i < NUM_FACE_MOVES; i++)
+	{
+		Move move = (Move)i;
+		int face = moveFace(move);
+		if(isRedundantMove(face, lastFace))
+			continue;
+
+		if(++nodes % STOP_CHECK_INTERVAL == 0)
+			search.checkStop();
+
+		Node next = search.solver.applyMove(node, move);
+		if(search.solver.heuristic(next, remaining - 1) > remaining - 1)
+			continue;
+
+		path[depth] = move;
+		if(searchFrom(next, depth + 1, remaining - 1, face))
+			return true;
+
+		if(search.stopped.load(std::memory_order_relaxed))
+			return false;
+	}
+
+	return false;
+}
+
+double OptimalSolver::Statistics::nodesPerSecond() const
+{
+	return (seconds > 0.0) ? (double)nodes / seconds : 0.0;
+}
+
+OptimalSolver::OptimalSolver() :
+	tableFile{}, tableBuffer{}, cancelled{false},
+	cornerPermutationMove{nullptr}, twistMove{nullptr},
+	cornerPrune{nullptr}, edgePrune{}
+{}
+
+bool OptimalSolver::loadTables(const char* path)
+{
+	trace::Zone zone{"optimal loadTables"};
+
+	if(tableFile.open(path))
+	{
+		if((tableFile.size() == LAYOUT.size) && isCurrentHeader(tableFile.data()))
+		{
+			assignTables(tableFile.data());
+			return true;
+		}
+
+		printf("Ignoring stale optimal solver tables in %s\n", path);
+		tableFile.close();
+	}
+
+	printf("Generating optimal solver tables into %s\n", path);
+
+	tableBuffer.assign(LAYOUT.size, 0);
+	generateTables(tableBuffer.data());
+
+	if(MappedFile::write(path, tableBuffer.data(), tableBuffer.size()) && tableFile.open(path))
+	{
+		tableBuffer.clear();
+		tableBuffer.shrink_to_fit();
+		assignTables(tableFile.data());
+		return true;
+	}
+
+	printf("Keeping the optimal solver tables in memory only\n");
+	assignTables(tableBuffer.data());
+	return false;
+}
+
+bool OptimalSolver::isReady() const
+{
+	return cornerPrune != nullptr;
+}
+
+void OptimalSolver::cancel()
+{
+	cancelled.store(true, std::memory_order_relaxed);
+}
+
+void OptimalSolver::assignTables(const unsigned char* data)
+{
+	cornerPermutationMove = (const unsigned short*)(data + LAYOUT.cornerPermutationMove);
+	twistMove = (const unsigned short*)(data + LAYOUT.twistMove);
+
+	cornerPrune = data + LAYOUT.cornerPrune;
+	for(int i = 0; i < NUM_EDGE_SETS; i++)
+		edgePrune[i] = data + LAYOUT.edgePrune[i];
+}
+
+void OptimalSolver::generateTables(unsigned char* data)
+{
+	using namespace coordinates;
+
+	writeHeader(data);
+
+	unsigned short* cornerPermutationMoveTable = (unsigned short*)(data + LAYOUT.cornerPermutationMove);
+	unsigned short* twistMoveTable = (unsigned short*)(data + LAYOUT.twistMove);
+
+	for(int coordinate = 0; coordinate < NUM_CORNER_PERMUTATIONS; coordinate++)
+	{
+		CubeState state;
+		setCornerPermutation(state, coordinate);
+
+		for(int move = 0; move < NUM_FACE_MOVES; move++)
+		{
+			CubeState moved = state;
+			moved.applyMove((Move)move);
+			cornerPermutationMoveTable[coordinate * NUM_FACE_MOVES + move] = (unsigned short)cornerPermutation(moved);
+		}
+	}
+
+	for(int coordinate = 0; coordinate < NUM_TWISTS; coordinate++)
+	{
+		CubeState state;
+		setTwist(state, coordinate);
+
+		for(int move = 0; move < NUM_FACE_MOVES; move++)
+		{
+			CubeState moved = state;
+			moved.applyMove((Move)move);
+			twistMoveTable[coordinate * NUM_FACE_MOVES + move] = (unsigned short)twist(moved);
+		}
+	}
+
+	buildPatternDatabase(data + LAYOUT.cornerPrune, NUM_CORNER_PATTERNS, 0,
+		[=](size_t index, size_t* neighbours)
+		{
+			size_t permutation = index / NUM_TWISTS, twist = index % NUM_TWISTS;
+			for(int move = 0; move < NUM_FACE_MOVES; move++)
+			{
+				neighbours[move] = (size_t)cornerPermutationMoveTable[permutation * NUM_FACE_MOVES + move] * NUM_TWISTS
+								   + twistMoveTable[twist * NUM_FACE_MOVES + move];
+			}
+		});
+
+	for(int set = 0; set < NUM_EDGE_SETS; set++)
+	{
+		unsigned char solvedEdges[EDGES_PER_SET];
+		for(int i = 0; i < EDGES_PER_SET; i++)
+			solvedEdges[i] = (unsigned char)((set * EDGES_PER_SET + i) * 2);
+
+		buildPatternDatabase(data + LAYOUT.edgePrune[set], NUM_EDGE_PATTERNS, edgePatternIndex(solvedEdges),
+			[](size_t index, size_t* neighbours)
+			{
+				unsigned char edges[EDGES_PER_SET], moved[EDGES_PER_SET];
+				setEdgePatternIndex(edges, (int)index);
+
+				for(int move = 0; move < NUM_FACE_MOVES; move++)
+				{
+					for(int i = 0; i < EDGES_PER_SET; i++)
+						moved[i] = EDGE_MOVES.target[move][edges[i]];
+					neighbours[move] = edgePatternIndex(moved);
+				}
+			});
+	}
+}
+
+OptimalSolver::Node OptimalSolver::makeNode(const CubeState& state) const
+{
+	Node node;
+	node.cornerPermutation = (unsigned short)coordinates::cornerPermutation(state);
+	node.twist = (unsigned short)coordinates::twist(state);
+
+	for(int slot = 0; slot < CubeState::NUM_EDGES; slot++)
+	{
+		int edge = state.edgePermutation[slot];
+		node.edges[edge / EDGES_PER_SET][edge % EDGES_PER_SET] = (unsigned char)(slot * 2 + state.edgeOrientation[slot]);
+	}
+
+	return node;
+}
+
+OptimalSolver::Node OptimalSolver::applyMove(const Node& node, Move move) const
+{
+	Node next;
+	next.cornerPermutation = cornerPermutationMove[node.cornerPermutation * NUM_FACE_MOVES + move];
+	next.twist = twistMove[node.twist * NUM_FACE_MOVES + move];
+
+	for(int set = 0; set < NUM_EDGE_SETS; set++)
+	{
+		for(int i = 0; i < EDGES_PER_SET; i++)
+			next.edges[set][i] = EDGE_MOVES.target[move][node.edges[set][i]];
+	}
+
+	return next;
+}
+
+int OptimalSolver::heuristic(const Node& node, int bound) const
+{
+	// The edge indices are the expensive part, skip them once the corners alone exceed the bound
+	int distance = prunedDistance(cornerPrune, (size_t)node.cornerPermutation * coordinates::NUM_TWISTS + node.twist);
+	for(int set = 0; (set < NUM_EDGE_SETS) && (distance <= bound); set++)
+		distance = std::max(distance, prunedDistance(edgePrune[set], edgePatternIndex(node.edges[set])));
+	return distance;
+}
+
+bool OptimalSolver::solve(const CubeState& state, MoveSequence& solution,
+						  float timeLimitSeconds, int numThreads, Statistics* statistics)
+{
+	trace::Zone zone{"optimal solve"};
+
+	// A cancel() is only cleared once the solve it was meant for returns, one that lands before the search starts
+	// still stops it
+	if(!isReady())
+	{
+		printf("Optimal solver tables are not loaded\n");
+		cancelled.store(false, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Searched with the cube turned so its centers are home, and its face moves mapped back
+	CubeState homed = state;
+	Move faceMoves[NUM_FACE_MOVES];
+	if(!homed.rotateCentersHome(faceMoves) || !homed.isSolvable())
+	{
+		printf("Cannot solve an unreachable cube state\n");
+		cancelled.store(false, std::memory_order_relaxed);
+		return false;
+	}
+
+	if(numThreads <= 0)
+		numThreads = defaultThreadCount();
+
+	auto startTime = std::chrono::steady_clock::now();
+	Node root = makeNode(homed);
+
+	long long totalNodes = 0;
+	bool solved = false;
+	int bound = heuristic(root);
+
+	for(; bound <= MAX_SOLUTION_LENGTH; bound++)
+	{
+		trace::Zone boundZone{"optimal bound"};
+
+		if(cancelled.load(std::memory_order_relaxed))
+			break;
+
+		Search search{*this, root, bound, timeLimitSeconds > 0.0f,
+					  startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+						  std::chrono::duration<float>{timeLimitSeconds})};
+
+		if(bound < NUM_TASK_PLIES)
+		{
+			Worker& worker = search.workers.emplace_back(search, 0);
+			if(worker.searchFrom(root, 0, bound, NO_FACE))
+				search.submit(worker.path);
+		}
+		else
+		{
+			for(int i = 0; i < numThreads; i++)
+				search.workers.emplace_back(search, i);
+
+			int numTasks = 0;
+			for(int first = 0; first < NUM_FACE_MOVES; first++)
+			{
+				for(int second = 0; second < NUM_FACE_MOVES; second++)
+				{
+					if(isRedundantMove(moveFace((Move)second), moveFace((Move)first)))
+						continue;
+
+					search.workers[numTasks++ % numThreads].tasks.push_back({(Move)first, (Move)second});
+				}
+			}
+
+			std::vector<std::thread> threads;
+			for(Worker& worker : search.workers)
+				threads.emplace_back(&Worker::run, &worker);
+			for(std::thread& thread : threads)
+				thread.join();
+		}
+
+		for(const Worker& worker : search.workers)
+			totalNodes += worker.nodes;
+
+		if(search.found)
+		{
+			for(int i = 0; i < bound; i++)
+				search.solution[i] = faceMoves[search.solution[i]];
+
+			solution.assign(search.solution, bound);
+			solved = true;
+			break;
+		}
+
+		if(search.stopped)
+			break;
+	}
+
+	if(statistics)
+	{
+		statistics->nodes = totalNodes;
+		statistics->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		statistics->depth = std::min(bound, (int)MAX_SOLUTION_LENGTH);
+	}
+
+	cancelled.store(false, std::memory_order_relaxed);
+	return solved;
+}
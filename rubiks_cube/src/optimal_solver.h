@@ -0,0 +1,74 @@
+#ifndef OPTIMAL_SOLVER_H
+#define OPTIMAL_SOLVER_H
+
+#include "cube_state.h"
+#include "mapped_file.h"
+#include "move_sequence.h"
+
+#include <atomic>
+#include <vector>
+
+/*
+	Optimal solver, IDA* bounded by three pattern databases (Korf) :
+	all corners, the first six edges and the last six edges, each stored as 4-bit distances.
+	Every iteration splits the tree into its two-ply subtrees, which worker threads take from their own queue
+	and steal from the others' once it runs dry.
+	Tables (~88 MB) are generated on first use, written to disk and memory-mapped afterwards.
+*/
+class OptimalSolver
+{
+public :
+	static constexpr int
+		MAX_SOLUTION_LENGTH = 20,
+		NUM_EDGE_SETS = 2;
+
+	static constexpr float NO_TIME_LIMIT = 0.0f;
+
+	struct Statistics
+	{
+		long long nodes;
+		double seconds;
+		int depth;
+
+		double nodesPerSecond() const;
+	};
+
+	OptimalSolver();
+
+	// Maps the tables from path, or generates them when it is missing or holds tables from another version or build,
+	// and writes them there. Returns false if they could not be written, they are then kept in memory only
+	bool loadTables(const char* path);
+	bool isReady() const;
+
+	// Returns false if the time limit ran out or the search was cancelled before an optimal solution was found.
+	// Moved centers are solved around, as by the two-phase solver
+	bool solve(const CubeState& state, MoveSequence& solution,
+			   float timeLimitSeconds = NO_TIME_LIMIT, int numThreads = 0, Statistics* statistics = nullptr);
+
+	// Stops a running solve() from any thread, or the next one to start if none is running. Cleared as solve() returns
+	void cancel();
+
+private :
+	struct Node;
+	struct Search;
+	struct Worker;
+
+	MappedFile tableFile;
+	std::vector<unsigned char> tableBuffer;
+	std::atomic<bool> cancelled;
+
+	const unsigned short* cornerPermutationMove;
+	const unsigned short* twistMove;
+
+	const unsigned char* cornerPrune;
+	const unsigned char* edgePrune[NUM_EDGE_SETS];
+
+	Node makeNode(const CubeState& state) const;
+	Node applyMove(const Node& node, Move move) const;
+	int heuristic(const Node& node, int bound = MAX_SOLUTION_LENGTH) const;
+
+	void assignTables(const unsigned char* data);
+	static void generateTables(unsigned char* data);
+};
+
+#endif
@@ -1,46 +1,114 @@
 #include "rubiks_cube.h"
+#include "cube_rotations.h"
 #include "models.h"
+#include "trace.h"
 
-void RubiksCube::rotateFaceVoxIndices(VoxIndexRotation rotation)
-{
-	const Index* face = FACES_POS_INDEX[selectedFace];
+#include <array>
+#include <algorithm>
+#include <numeric>
 
-	switch(rotation)
+namespace
+{
+	std::array<glm::quat, rotations::NUM_ROTATIONS> buildRotationQuaternions()
 	{
-		case CLOCKWISE :
+		std::array<glm::quat, rotations::NUM_ROTATIONS> quaternions{};
+
+		for(int rotation = 0; rotation < rotations::NUM_ROTATIONS; rotation++)
 		{
-			std::swap(posToVoxIndex[face[2]], posToVoxIndex[face[0]]);
-			std::swap(posToVoxIndex[face[0]], posToVoxIndex[face[6]]);
-			std::swap(posToVoxIndex[face[6]], posToVoxIndex[face[8]]);
+			const rotations::Matrix& matrix = rotations::matrix(rotation);
 
-			std::swap(posToVoxIndex[face[1]], posToVoxIndex[face[3]]);
-			std::swap(posToVoxIndex[face[3]], posToVoxIndex[face[7]]);
-			std::swap(posToVoxIndex[face[7]], posToVoxIndex[face[5]]);
+			glm::mat3 rotationMatrix{};
+			for(int row = 0; row < 3; row++)
+			{
+				for(int column = 0; column < 3; column++)
+					rotationMatrix[column][row] = (float)matrix.m[row][column];
+			}
 
-			break;
+			quaternions[rotation] = glm::quat_cast(rotationMatrix);
 		}
 
-		case COUNTER_CLOCKWISE :
-		{
-			std::swap(posToVoxIndex[face[2]], posToVoxIndex[face[8]]);
-			std::swap(posToVoxIndex[face[8]], posToVoxIndex[face[6]]);
-			std::swap(posToVoxIndex[face[6]], posToVoxIndex[face[0]]);
+		return quaternions;
+	}
 
-			std::swap(posToVoxIndex[face[1]], posToVoxIndex[face[5]]);
-			std::swap(posToVoxIndex[face[5]], posToVoxIndex[face[7]]);
-			std::swap(posToVoxIndex[face[7]], posToVoxIndex[face[3]]);
+	const std::array<glm::quat, rotations::NUM_ROTATIONS> ROTATION_QUATERNIONS = buildRotationQuaternions();
 
-			break;
-		}
+	const glm::quat IDENTITY_ROTATION{1.0f, 0.0f, 0.0f, 0.0f};
 
-		case DOUBLE :
+	// rotatePosition for layer indices, which count from 0 instead of being centered on the core
+	RubiksCube::Index rotateLayerPosition(RubiksCube::Index p, int axis, int quarterTurns, int size)
+	{
+		int last = size - 1;
+
+		for(int turn = 0; turn < quarterTurns; turn++)
 		{
-			std::swap(posToVoxIndex[face[0]], posToVoxIndex[face[8]]);
-			std::swap(posToVoxIndex[face[1]], posToVoxIndex[face[7]]);
-			std::swap(posToVoxIndex[face[2]], posToVoxIndex[face[6]]);
-			std::swap(posToVoxIndex[face[3]], posToVoxIndex[face[5]]);
+			switch(axis)
+			{
+				case 0 : p = {p.x, last - p.z, p.y}; break;
+				case 1 : p = {p.z, p.y, last - p.x}; break;
+				default : p = {last - p.y, p.x, p.z}; break;
+			}
+		}
+
+		return p;
+	}
+
+	bool sameLayers(const RubiksCube::LayerTurn& a, const RubiksCube::LayerTurn& b)
+	{
+		return (a.axis == b.axis) && (a.firstLayer == b.firstLayer) && (a.lastLayer == b.lastLayer);
+	}
+}
+
+int RubiksCube::numSurfaceCubies(int size)
+{
+	// Two full outer layers along x, and the rims of the inner ones
+	return (size == 1) ? 1 : (2 * size * size + (size - 2) * (4 * size - 4));
+}
+
+float RubiksCube::halfExtent(int size)
+{
+	return 0.5f * (size - 1) * VOX_SPACING + 0.5f * models::cube::CUBE_SIDE_LENGTH;
+}
+
+unsigned int RubiksCube::slotIndex(Index position) const
+{
+	unsigned int square = size * size, rim = 4 * size - 4;
+
+	if(position.x == 0)
+		return position.y * size + position.z;
 
-			break;
+	unsigned int firstSlot = square + (position.x - 1) * rim;
+
+	if(position.x == size - 1)
+		return firstSlot + position.y * size + position.z;
+
+	// The rim of an inner layer : the full rows at y = 0 and y = size - 1, then both ends of the rows between them
+	if(position.y == 0)
+		return firstSlot + position.z;
+	else if(position.y == size - 1)
+		return firstSlot + size + position.z;
+	else
+		return firstSlot + 2 * size + (position.y - 1) * 2 + ((position.z == 0) ? 0 : 1);
+}
+
+template<typename Function>
+void RubiksCube::forEachInLayer(int axis, int layer, Function function) const
+{
+	int uAxis = (axis + 1) % 3, vAxis = (axis + 2) % 3;
+	bool outer = (layer == 0) || (layer == size - 1);
+
+	Index position{};
+	position[axis] = layer;
+
+	for(int u = 0; u < size; u++)
+	{
+		position[uAxis] = u;
+
+		// An inner layer is hollow, only the ends of its inner rows are stored
+		int vStep = (outer || (u == 0) || (u == size - 1)) ? 1 : (size - 1);
+		for(int v = 0; v < size; v += vStep)
+		{
+			position[vAxis] = v;
+			function(position, slotIndex(position));
 		}
 	}
 }
@@ -56,49 +124,244 @@ float RubiksCube::getPrincipleAngle(float radians) const
 		return inRange;
 }
 
-RubiksCube::RubiksCube() :
-	colors{}, voxTransforms{}, posToVoxIndex{}, 
-	snapped{true}, faceRotationRads{0.0f}, selectedFace{FACE_POS_X}, globalTransform{}
+RubiksCube::RubiksCube(int size) :
+	size{size}, numCubies{numSurfaceCubies(size)},
+	slotCubies(numCubies), cubieOrientations(numCubies), layerCubies(size * size),
+	vertices(6 * size * size * STICKER_NUM_VERTS + MAX_BODY_BOXES * BOX_NUM_VERTS),
+	indices(6 * size * size * STICKER_NUM_INDICES + MAX_BODY_BOXES * BOX_NUM_INDICES),
+	numBodyBoxes{0}, bodyTurning{false}, bodyTurn{}, meshRevision{0},
+	transforms(numCubies + 2), transformsOutdated{true}, transformsTurning{false}, transformsTurn{},
+	state{}, snapped{true}, faceRotationRads{0.0f}, animatedMove{MOVE_R, 0}, animatedMoveFraction{0.0f},
+	selectedFace{FACE_POS_X}, selectedDepth{1}, globalTransform{}
 {
-	std::copy(models::cube::positions, models::cube::positions + VOX_NUM_VERTS, vertexPositions);
-	std::copy(models::cube::indices, models::cube::indices + VOX_NUM_INDICES, vertexIndices);
+	buildStickers();
+
+	// Every box is drawn with the same triangles, so the body's indices never change, only how many are drawn
+	for(int box = 0; box < MAX_BODY_BOXES; box++)
+	{
+		unsigned int firstVertex = (unsigned int)(getBodyFirstVertex() + box * BOX_NUM_VERTS);
+		unsigned int* boxIndices = indices.data() + (indices.size() - (MAX_BODY_BOXES - box) * BOX_NUM_INDICES);
+
+		for(int index = 0; index < BOX_NUM_INDICES; index++)
+			boxIndices[index] = firstVertex + models::cube::indices[index];
+	}
+
+	buildBody(false, LayerTurn{});
+
+	reset();
+}
 
+void RubiksCube::buildStickers()
+{
+	int sticker = 0;
 	for(int face = 0; face < NUM_FACES; face++)
 	{
-		for(int voxel = 0; voxel < CUBE_NUM_VOXES_PER_FACE; voxel++)
+		int axis = face / 2;
+		int layer = (face % 2 == 0) ? (size - 1) : 0;
+
+		forEachInLayer(axis, layer, [&](Index, unsigned int slot)
 		{
-			Index posIndex = FACES_POS_INDEX[face][voxel];
-			Index voxIndex = posIndex + Index{1, 1, 1};
+			// The voxel model's face of the same index, in the space of the cubie starting in this slot
+			Vertex* stickerVertices = vertices.data() + sticker * STICKER_NUM_VERTS;
+			for(int vertex = 0; vertex < STICKER_NUM_VERTS; vertex++)
+				stickerVertices[vertex] = {models::cube::positions[face * STICKER_NUM_VERTS + vertex], slot, (unsigned char)face};
+
+			unsigned int* stickerIndices = indices.data() + sticker * STICKER_NUM_INDICES;
+			for(int index = 0; index < STICKER_NUM_INDICES; index++)
+				stickerIndices[index] = sticker * STICKER_NUM_VERTS + models::cube::indices[index];
 
-			posToVoxIndex[posIndex] = voxIndex;
+			sticker++;
+		});
+	}
+}
 
-			glm::vec3 position = posIndex;
-			position *= VOX_SPACING;
-			voxTransformsIndexed[voxIndex.x][voxIndex.y][voxIndex.z].position = position;
+void RubiksCube::buildBody(bool turning, const LayerTurn& turn) const
+{
+	float extent = halfExtent(size) - BODY_INSET;
 
-			for(size_t vertex = 0; vertex < VOX_NUM_VERTS_PER_FACE; vertex++)
-				voxFaceColorsIndexed[voxIndex.x][voxIndex.y][voxIndex.z][face][vertex] = FACE_COLORS[face];
+	// Layers along the turning axis each box covers, boxes are split halfway between voxels
+	struct BodyBox
+	{
+		int firstLayer, lastLayer;
+		unsigned int transform;
+	};
+
+	unsigned int fixedTransform = numCubies, turningTransform = numCubies + 1;
+
+	BodyBox boxes[MAX_BODY_BOXES];
+	numBodyBoxes = 0;
+
+	if(!turning)
+	{
+		boxes[numBodyBoxes++] = {0, size - 1, fixedTransform};
+	}
+	else
+	{
+		if(turn.firstLayer > 0)
+			boxes[numBodyBoxes++] = {0, turn.firstLayer - 1, fixedTransform};
+
+		boxes[numBodyBoxes++] = {turn.firstLayer, turn.lastLayer, turningTransform};
+
+		if(turn.lastLayer < size - 1)
+			boxes[numBodyBoxes++] = {turn.lastLayer + 1, size - 1, fixedTransform};
+	}
+
+	int axis = turning ? turn.axis : 0;
+	float center = 0.5f * (size - 1);
+
+	for(int box = 0; box < numBodyBoxes; box++)
+	{
+		glm::vec3 boxMin{-extent}, boxMax{extent};
+		if(boxes[box].firstLayer > 0)
+			boxMin[axis] = (boxes[box].firstLayer - center - 0.5f) * VOX_SPACING;
+		if(boxes[box].lastLayer < size - 1)
+			boxMax[axis] = (boxes[box].lastLayer - center + 0.5f) * VOX_SPACING;
+
+		glm::vec3 boxCenter = 0.5f * (boxMin + boxMax), boxSize = boxMax - boxMin;
+
+		Vertex* boxVertices = vertices.data() + getBodyFirstVertex() + box * BOX_NUM_VERTS;
+		for(int vertex = 0; vertex < BOX_NUM_VERTS; vertex++)
+		{
+			boxVertices[vertex] = {boxCenter + boxSize * (models::cube::positions[vertex] / models::cube::CUBE_SIDE_LENGTH),
+								   boxes[box].transform, (unsigned char)COLOR_BODY};
 		}
 	}
 
-	Index posIndex{0, 0, 0};
-	Index voxIndex{1, 1, 1};
-	posToVoxIndex[posIndex] = voxIndex;
+	bodyTurning = turning;
+	bodyTurn = turn;
+	meshRevision++;
+}
+
+int RubiksCube::getSize() const
+{
+	return size;
+}
+
+int RubiksCube::getNumCubies() const
+{
+	return numCubies;
+}
+
+RubiksCube::LayerTurn RubiksCube::layerTurn(LayerMove move) const
+{
+	MoveGeometry geometry = moveGeometry(move.move);
+	int family = moveFace(move.move);
+	int lastLayer = size - 1;
+
+	LayerTurn turn{geometry.axis, 0, lastLayer, geometry.quarterTurns};
+
+	// Layers counted in from the move's face, which is on the positive side when the 3x3x3 geometry ends there
+	bool positive = geometry.lastLayer > 0;
+
+	if(family < FAMILY_SLICE)
+	{
+		int depth = std::clamp((int)move.depth, 1, size);
+		turn.firstLayer = turn.lastLayer = positive ? (size - depth) : (depth - 1);
+	}
+	else if(family < FAMILY_WIDE)
+	{
+		// Empty below 3x3x3, so the turn does nothing
+		turn.firstLayer = 1;
+		turn.lastLayer = lastLayer - 1;
+	}
+	else if(family < FAMILY_ROTATION)
+	{
+		int depth = std::min((move.depth == 0) ? 2 : (int)move.depth, size);
+
+		if(positive)
+			turn.firstLayer = size - depth;
+		else
+			turn.lastLayer = depth - 1;
+	}
+
+	return turn;
+}
+
+RubiksCube::LayerTurn RubiksCube::layerTurn(Move move) const
+{
+	return layerTurn(LayerMove{move, 0});
+}
+
+const Transform* RubiksCube::getTransforms() const
+{
+	if(transformsOutdated)
+		updateTransforms();
+
+	return transforms.data();
+}
+
+size_t RubiksCube::getNumTransforms() const
+{
+	return transforms.size();
+}
+
+const RubiksCube::Vertex* RubiksCube::getVertices() const
+{
+	if(transformsOutdated)
+		updateTransforms();
+
+	return vertices.data();
+}
+
+size_t RubiksCube::getNumVertices() const
+{
+	return vertices.size();
+}
+
+const unsigned int* RubiksCube::getIndices() const
+{
+	return indices.data();
+}
+
+size_t RubiksCube::getNumMeshIndices() const
+{
+	return indices.size();
+}
+
+size_t RubiksCube::getNumIndices() const
+{
+	if(transformsOutdated)
+		updateTransforms();
+
+	return indices.size() - (MAX_BODY_BOXES - numBodyBoxes) * BOX_NUM_INDICES;
+}
+
+unsigned int RubiksCube::getMeshRevision() const
+{
+	if(transformsOutdated)
+		updateTransforms();
+
+	return meshRevision;
+}
+
+size_t RubiksCube::getBodyFirstVertex() const
+{
+	return vertices.size() - MAX_BODY_BOXES * BOX_NUM_VERTS;
 }
 
-const glm::vec4* RubiksCube::getColors() const
+const CubeState& RubiksCube::getState() const
 {
-	return colors;
+	return state;
 }
 
-const glm::vec3* RubiksCube::getVoxelVertexPositions() const
+const unsigned char* RubiksCube::getOrientations() const
 {
-	return vertexPositions;
+	return cubieOrientations.data();
 }
 
-const unsigned int* RubiksCube::getVoxelIndices() const
+void RubiksCube::reset()
 {
-	return vertexIndices;
+	std::iota(slotCubies.begin(), slotCubies.end(), 0u);
+	std::fill(cubieOrientations.begin(), cubieOrientations.end(), (unsigned char)rotations::IDENTITY);
+	state = CubeState{};
+
+	snapped = true;
+	faceRotationRads = 0.0f;
+	animatedMoveFraction = 0.0f;
+
+	setLayerTransforms(LayerTurn{0, 0, size - 1, 0}, IDENTITY_ROTATION);
+	transformsTurning = false;
+	transformsOutdated = true;
 }
 
 bool RubiksCube::isSnapped() const
@@ -108,62 +371,195 @@ bool RubiksCube::isSnapped() const
 
 void RubiksCube::snapFace()
 {
+	trace::Zone zone{"snapFace"};
+
 	float rotatedDegs = glm::degrees(getPrincipleAngle(faceRotationRads));
 	float rotatedDegsMag = fabsf(rotatedDegs);
 
-	float remainingRotationRads;
-
 	if((rotatedDegsMag <= 180.0f) && (rotatedDegsMag >= 135.0f))
 	{
-		rotateFaceVoxIndices(DOUBLE);
-		remainingRotationRads = glm::radians(180.0f - rotatedDegs);
+		turnLayers(selectedLayerMove(TURN_DOUBLE));
 	}
 	else if((rotatedDegs >= 45.0f) && (rotatedDegs <= 135.0f))
 	{
-		rotateFaceVoxIndices(COUNTER_CLOCKWISE);
-		remainingRotationRads = glm::radians(90.0f - rotatedDegs);
+		turnLayers(selectedLayerMove(TURN_COUNTER_CLOCKWISE));
 	}
 	else if((rotatedDegs <= -45.0f) && (rotatedDegs >= -135.0f))
 	{
-		rotateFaceVoxIndices(CLOCKWISE);
-		remainingRotationRads = glm::radians(-90.0f - rotatedDegs);
+		turnLayers(selectedLayerMove(TURN_CLOCKWISE));
 	}
-	else
+
+	faceRotationRads = 0.0f;
+	snapped = true;
+	transformsOutdated = true;
+}
+
+void RubiksCube::rotateFace(float radians)
+{
+	trace::Zone zone{"rotateFace"};
+
+	faceRotationRads += radians;
+	snapped = false;
+	transformsOutdated = true;
+}
+
+glm::quat RubiksCube::moveRotation(Move move, float fraction) const
+{
+	MoveGeometry geometry = moveGeometry(move);
+
+	glm::vec3 axis{0.0f};
+	axis[geometry.axis] = 1.0f;
+
+	return glm::angleAxis(fraction * glm::radians(90.0f * geometry.quarterTurns), axis);
+}
+
+LayerMove RubiksCube::selectedLayerMove(MoveTurn turn) const
+{
+	return {makeMove(selectedFace, turn), (unsigned char)std::clamp(selectedDepth, 1, size)};
+}
+
+void RubiksCube::turnLayers(LayerMove move)
+{
+	LayerTurn turn = layerTurn(move);
+	int rotation = rotations::quarterTurn(turn.axis, turn.quarterTurns);
+
+	// A move with a depth turns the same layers as some plain move on a 3x3x3 (2R is M'), which the state can take
+	if((size == 3) && (move.depth == 0))
+	{
+		state.applyMove(move.move);
+	}
+	else if(size == 3)
 	{
-		remainingRotationRads = glm::radians(-rotatedDegs);
+		for(int plainMove = 0; plainMove < NUM_MOVES; plainMove++)
+		{
+			LayerTurn plainTurn = layerTurn((Move)plainMove);
+			if(sameLayers(plainTurn, turn) && (plainTurn.quarterTurns == turn.quarterTurns))
+			{
+				state.applyMove((Move)plainMove);
+				break;
+			}
+		}
 	}
 
-	for(const Index& posIndex : FACES_POS_INDEX[selectedFace])
+	for(int layer = turn.firstLayer; layer <= turn.lastLayer; layer++)
 	{
-		const Index& voxIndex = posToVoxIndex[posIndex];
-		Transform& voxTransform = voxTransformsIndexed[voxIndex.x][voxIndex.y][voxIndex.z];
+		// Gathered first, as the layer's cubies only move between its own slots
+		int numLayerCubies = 0;
+		forEachInLayer(turn.axis, layer, [&](Index, unsigned int slot)
+		{
+			layerCubies[numLayerCubies++] = slotCubies[slot];
+		});
 
-		voxTransform.position = VOX_SPACING * glm::vec3{posIndex};
-		voxTransform.rotation = glm::angleAxis(remainingRotationRads, FACES_ROTATION_AXIS[selectedFace]) 
-								* voxTransform.rotation;
+		numLayerCubies = 0;
+		forEachInLayer(turn.axis, layer, [&](Index position, unsigned int)
+		{
+			unsigned int cubie = layerCubies[numLayerCubies++];
+			slotCubies[slotIndex(rotateLayerPosition(position, turn.axis, turn.quarterTurns, size))] = cubie;
+			cubieOrientations[cubie] = (unsigned char)rotations::compose(cubieOrientations[cubie], rotation);
+		});
 	}
 
-	faceRotationRads = 0.0f;
+	setLayerTransforms(turn, IDENTITY_ROTATION);
 }
 
-void RubiksCube::rotateFace(float radians)
+void RubiksCube::setLayerTransforms(const LayerTurn& turn, const glm::quat& rotation) const
 {
-	glm::quat rotation = glm::angleAxis(radians, FACES_ROTATION_AXIS[selectedFace]);
-	faceRotationRads += radians;
+	float center = 0.5f * (size - 1);
 
-	for(const Index& posIndex : FACES_POS_INDEX[selectedFace])
+	for(int layer = turn.firstLayer; layer <= turn.lastLayer; layer++)
 	{
-		const Index& voxIndex = posToVoxIndex.at(posIndex);
-		Transform& voxTransform = voxTransformsIndexed[voxIndex.x][voxIndex.y][voxIndex.z];
+		forEachInLayer(turn.axis, layer, [&](Index position, unsigned int slot)
+		{
+			unsigned int cubie = slotCubies[slot];
+			Transform& cubieTransform = transforms[cubie];
 
-		voxTransform.rotation = rotation * voxTransform.rotation;
-		voxTransform.position = rotation * voxTransform.position;
+			cubieTransform.position = rotation * (VOX_SPACING * (glm::vec3{position} - center));
+			cubieTransform.rotation = rotation * ROTATION_QUATERNIONS[cubieOrientations[cubie]];
+		});
 	}
+}
 
-	snapped = false;
+void RubiksCube::updateTransforms() const
+{
+	// At most one set of layers is in flight : the face being rotated by hand or the move being animated
+	bool turning = false;
+	LayerTurn turn{};
+	glm::quat turningRotation = IDENTITY_ROTATION;
+
+	if(!snapped)
+	{
+		turning = true;
+		turn = layerTurn(selectedLayerMove(TURN_CLOCKWISE));
+		turningRotation = glm::angleAxis(faceRotationRads, FACES_ROTATION_AXIS[selectedFace]);
+	}
+	else if(animatedMoveFraction > 0.0f)
+	{
+		turning = true;
+		turn = layerTurn(animatedMove);
+		turningRotation = moveRotation(animatedMove.move, animatedMoveFraction);
+	}
+
+	turning = turning && (turn.firstLayer <= turn.lastLayer);
+
+	// Layers that were in flight and no longer are go back to snapped
+	if(transformsTurning && !(turning && sameLayers(turn, transformsTurn)))
+		setLayerTransforms(transformsTurn, IDENTITY_ROTATION);
+
+	if(turning)
+		setLayerTransforms(turn, turningRotation);
+
+	transformsTurning = turning;
+	transformsTurn = turn;
+
+	// The fixed part of the body is the whole cube when no layer turns
+	transforms[numCubies] = Transform{};
+	transforms[numCubies + 1] = Transform{};
+	transforms[numCubies + 1].rotation = turningRotation;
+
+	if((turning != bodyTurning) || (turning && !sameLayers(turn, bodyTurn)))
+		buildBody(turning, turn);
+
+	transformsOutdated = false;
 }
 
-const Transform* RubiksCube::getTransforms() const
+void RubiksCube::animateMove(LayerMove move, float fraction)
+{
+	if(!snapped)
+		snapFace();
+
+	animatedMove = move;
+	animatedMoveFraction = fraction;
+	transformsOutdated = true;
+}
+
+void RubiksCube::animateMove(Move move, float fraction)
+{
+	animateMove(LayerMove{move, 0}, fraction);
+}
+
+void RubiksCube::applyMove(LayerMove move)
+{
+	if(!snapped)
+		snapFace();
+
+	turnLayers(move);
+	animatedMoveFraction = 0.0f;
+	transformsOutdated = true;
+}
+
+void RubiksCube::applyMove(Move move)
+{
+	applyMove(LayerMove{move, 0});
+}
+
+void RubiksCube::applyMoves(const MoveSequence& moves)
+{
+	for(Move move : moves)
+		applyMove(move);
+}
+
+void RubiksCube::applyMoves(const std::vector<LayerMove>& moves)
 {
-	return voxTransforms;
+	for(LayerMove move : moves)
+		applyMove(move);
 }
\ No newline at end of file
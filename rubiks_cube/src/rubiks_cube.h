@@ -4,34 +4,42 @@
 #include <glm/glm.hpp>
 
 #include "transform.h"
+#include "cube_state.h"
+#include "move_sequence.h"
 
-#include <unordered_map>
-
-template<>
-struct std::hash<glm::vec<3, int>>
-{
-	size_t operator()(const glm::vec<3, int>& vec) const noexcept
-	{
-		std::hash<int> intHash;
-		size_t ret = intHash(vec.x);
-		ret ^= intHash(vec.y) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
-		ret ^= intHash(vec.z) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
-		return ret;
-	}
-};
+#include <vector>
 
+/*
+	An NxNxN cube. Only the cubies on the surface are stored, so memory grows with N^2 and a layer turn only
+	touches the cubies in that layer. Slots and cubies share one numbering : a cubie's index is the slot it
+	starts in, layer by layer along x (an outer layer is a full N x N square, an inner one only its rim).
+*/
 class RubiksCube
 {
 public :
 	typedef glm::vec<3, int> Index;
 
 	static constexpr int
-		CUBE_NUM_VOXES = 27,
-		CUBE_NUM_VOXES_PER_FACE = 9,
-		VOX_NUM_VERTS = 24,
-		VOX_NUM_INDICES = 36,
+		DEFAULT_SIZE = 3,
+		MAX_SIZE = 256,
 		NUM_FACES = 6,
-		VOX_NUM_VERTS_PER_FACE = 4;
+		STICKER_NUM_VERTS = 4,
+		STICKER_NUM_INDICES = 6,
+		BOX_NUM_VERTS = 24,
+		BOX_NUM_INDICES = 36,
+		MAX_BODY_BOXES = 3;
+
+	// Stickers are colored by the face they start on, the body comes after them in the palette
+	static constexpr int
+		COLOR_BODY = NUM_FACES,
+		NUM_COLORS = NUM_FACES + 1;
+
+	struct Vertex
+	{
+		glm::vec3 position; // in the space of its transform
+		unsigned int transform; // index into getTransforms()
+		unsigned char color; // index into PALETTE
+	};
 
 	enum Face
 	{
@@ -43,57 +51,27 @@ public :
 		FACE_NEG_Z
 	};
 
-private :
-	enum VoxIndexRotation
+	// Layers 0 to size - 1 along the axis, counted from its negative side, quarter turns as in MoveGeometry
+	struct LayerTurn
 	{
-		CLOCKWISE,
-		COUNTER_CLOCKWISE,
-		DOUBLE
+		int axis;
+		int firstLayer, lastLayer;
+		int quarterTurns;
 	};
 
-	static constexpr Index FACES_POS_INDEX[NUM_FACES][CUBE_NUM_VOXES_PER_FACE]
-	{
-		// face +x
-		{{1, 1, 1}, {1, 1, 0}, {1, 1, -1},
-		{1, 0, 1}, {1, 0, 0}, {1, 0, -1},
-		{1, -1, 1}, {1, -1, 0}, {1, -1, -1}},
-
-		// face -x
-		{{-1, 1, -1}, {-1, 1, 0}, {-1, 1, 1},
-		{-1, 0, -1}, {-1, 0, 0}, {-1, 0, 1},
-		{-1, -1, -1}, {-1, -1, 0}, {-1, -1, 1}},
-
-		// face +y
-		{{-1, 1, -1}, {0, 1, -1}, {1, 1, -1},
-		{-1, 1, 0}, {0, 1, 0}, {1, 1, 0},
-		{-1, 1, 1}, {0, 1, 1}, {1, 1, 1}},
-
-		// face -y
-		{{1, -1, -1}, {0, -1, -1}, {-1, -1, -1},
-		{1, -1, 0}, {0, -1, 0}, {-1, -1, 0},
-		{1, -1, 1}, {0, -1, 1}, {-1, -1, 1}},
-
-		// face +z
-		{{-1, 1, 1}, {0, 1, 1}, {1, 1, 1},
-		{-1, 0, 1}, {0, 0, 1}, {1, 0, 1},
-		{-1, -1, 1}, {0, -1, 1}, {1, -1, 1}},
-
-		// face -z
-		{{1, 1, -1}, {0, 1, -1}, {-1, 1, -1},
-		{1, 0, -1}, {0, 0, -1}, {-1, 0, -1},
-		{1, -1, -1}, {0, -1, -1}, {-1, -1, -1}}
-	};
-
-	static constexpr glm::vec4 FACE_COLORS[NUM_FACES]
+	static constexpr glm::vec4 PALETTE[NUM_COLORS]
 	{
 		{0.0f, 0.0f, 1.0f, 1.0f}, // blue
 		{0.0f, 1.0f, 0.0f, 1.0f}, // green
 		{1.0f, 1.0f, 1.0f, 1.0f}, // white
 		{1.0f, 1.0f, 0.0f, 1.0f}, // yellow
 		{1.0f, 0.0f, 0.0f, 1.0f}, // red
-		{1.0f, 0.65, 0.0f, 1.0f} // orange
+		{1.0f, 0.65, 0.0f, 1.0f}, // orange
+		{0.0f, 0.0f, 0.0f, 1.0f} // body
 	};
 
+private :
+
 	static constexpr glm::vec3 FACES_ROTATION_AXIS[NUM_FACES]
 	{
 		{1.0f, 0.0f, 0.0f},
@@ -106,48 +84,120 @@ private :
 
 	static constexpr float VOX_SPACING = 1.3f;
 
-	glm::vec3 vertexPositions[VOX_NUM_VERTS];
-	unsigned int vertexIndices[VOX_NUM_INDICES];
+	// Sunk just below the stickers so they don't fight over depth
+	static constexpr float BODY_INSET = 0.01f;
 
-	union
-	{
-		glm::vec4 colors[CUBE_NUM_VOXES * VOX_NUM_VERTS];
+	const int size;
+	const int numCubies;
 
-		glm::vec4 voxColors[CUBE_NUM_VOXES][VOX_NUM_VERTS];
-		glm::vec4 voxColorsIndexed[3][3][3][VOX_NUM_VERTS];
+	// Cubie in each slot, and each cubie's snapped orientation as an index into the rotation group (see cube_rotations.h)
+	std::vector<unsigned int> slotCubies;
+	std::vector<unsigned char> cubieOrientations;
+	std::vector<unsigned int> layerCubies;
 
-		glm::vec4 voxFaceColors[CUBE_NUM_VOXES][NUM_FACES][VOX_NUM_VERTS_PER_FACE];
-		glm::vec4 voxFaceColorsIndexed[3][3][3][NUM_FACES][VOX_NUM_VERTS_PER_FACE];
-	};
+	// Only the exterior stickers are drawn, over a black body standing in for the voxels' unstickered faces.
+	// The body is one box, split along the turning axis while a layer is in flight so its inner faces show
+	mutable std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
 
-	union
-	{
-		Transform voxTransforms[CUBE_NUM_VOXES];
-		Transform voxTransformsIndexed[3][3][3];
-	};
+	mutable int numBodyBoxes;
+	mutable bool bodyTurning;
+	mutable LayerTurn bodyTurn;
+	mutable unsigned int meshRevision;
 
-	std::unordered_map<Index, Index> posToVoxIndex;
+	// The cubies' transforms, then the body's part that stays put and the part that turns with a layer.
+	// Kept snapped as layers turn, only the layers in flight carry a float angle, and only they are redone per frame
+	mutable std::vector<Transform> transforms;
+	mutable bool transformsOutdated;
+	mutable bool transformsTurning;
+	mutable LayerTurn transformsTurn;
+
+	// The logical 3x3x3 state for the solvers, only kept for a cube of that size
+	CubeState state;
 
 	bool snapped;
 	float faceRotationRads;
 
-	void rotateFaceVoxIndices(VoxIndexRotation rotation);
+	LayerMove animatedMove;
+	float animatedMoveFraction;
+
+	unsigned int slotIndex(Index position) const;
+
+	template<typename Function>
+	void forEachInLayer(int axis, int layer, Function function) const;
+
+	glm::quat moveRotation(Move move, float fraction) const;
+	LayerMove selectedLayerMove(MoveTurn turn) const;
+
+	void turnLayers(LayerMove move);
+	void setLayerTransforms(const LayerTurn& turn, const glm::quat& rotation) const;
+	void updateTransforms() const;
+
+	void buildStickers();
+	void buildBody(bool turning, const LayerTurn& turn) const;
+
 	float getPrincipleAngle(float radians) const;
 
 public :
+	// The layer turned by hand : selectedDepth layers in from selectedFace, 1 being the face itself
 	Face selectedFace;
+	int selectedDepth;
+
 	Transform globalTransform;
 
-	RubiksCube();
+	RubiksCube(int size = DEFAULT_SIZE);
+
+	static int numSurfaceCubies(int size);
+
+	// Half the side of the drawn cube, to fit a view to it
+	static float halfExtent(int size);
 
-	const glm::vec4* getColors() const;
+	int getSize() const;
+	int getNumCubies() const;
+
+	// The layers a move turns on a cube of this size, found without looking at any cubie.
+	// Without a depth wide turns take the two outer layers and slices every inner one
+	LayerTurn layerTurn(LayerMove move) const;
+	LayerTurn layerTurn(Move move) const;
+
+	// getNumCubies() cubie transforms then the body's two, which the vertices index
 	const Transform* getTransforms() const;
-	const glm::vec3* getVoxelVertexPositions() const;
-	const unsigned int* getVoxelIndices() const;
+	size_t getNumTransforms() const;
+
+	// The first getNumIndices() indices are drawn, getNumMeshIndices() is all of them
+	const Vertex* getVertices() const;
+	size_t getNumVertices() const;
+	const unsigned int* getIndices() const;
+	size_t getNumMeshIndices() const;
+	size_t getNumIndices() const;
+
+	// Changes whenever the vertices or the number of indices do, which is when a different layer starts or stops turning.
+	// Only the body's vertices, from getBodyFirstVertex() on, ever change
+	unsigned int getMeshRevision() const;
+	size_t getBodyFirstVertex() const;
+
+	// Only meaningful for a 3x3x3
+	const CubeState& getState() const;
+
+	// getNumCubies() of them
+	const unsigned char* getOrientations() const;
+
+	// Back to the solved cube, with nothing rotated or animated
+	void reset();
 
 	bool isSnapped() const;
 	void snapFace();
 	void rotateFace(float radians);
+
+	// Turns the move's layers to fraction (0 to 1) of the way through it, for animating a move before applyMove
+	void animateMove(LayerMove move, float fraction);
+	void animateMove(Move move, float fraction);
+
+	// Completes a move instantly, including any part already turned by animateMove. Snaps a partly rotated face first
+	void applyMove(LayerMove move);
+	void applyMove(Move move);
+	void applyMoves(const MoveSequence& moves);
+	void applyMoves(const std::vector<LayerMove>& moves);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,61 @@
+#include "stream_buffer.h"
+
+#include <stdio.h>
+
+StreamBuffer::StreamBuffer(unsigned int binding, size_t regionSize) :
+	binding{binding}, regionSize{regionSize}, regionStride{regionSize},
+	buffer{0}, mapping{nullptr}, fences{}, region{NUM_REGIONS - 1}
+{
+	// Each region is bound on its own, so it has to start where a binding offset may
+	int offsetAlignment = 1;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+	regionStride = (regionSize + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)(regionStride * NUM_REGIONS), nullptr, flags);
+	mapping = (unsigned char*)glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, (GLsizeiptr)(regionStride * NUM_REGIONS), flags);
+
+	if(!mapping)
+		printf("Failed to map stream buffer\n");
+}
+
+StreamBuffer::~StreamBuffer()
+{
+	for(GLsync& regionFence : fences)
+	{
+		if(regionFence)
+			glDeleteSync(regionFence);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+	glDeleteBuffers(1, &buffer);
+}
+
+void* StreamBuffer::beginWrite()
+{
+	region = (region + 1) % NUM_REGIONS;
+
+	GLsync& regionFence = fences[region];
+	if(regionFence)
+	{
+		while(glClientWaitSync(regionFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(regionFence);
+		regionFence = nullptr;
+	}
+
+	return mapping + region * regionStride;
+}
+
+void StreamBuffer::endWrite()
+{
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, binding, buffer, (GLintptr)(region * regionStride), (GLsizeiptr)regionSize);
+}
+
+void StreamBuffer::fence()
+{
+	fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,42 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include "util.h"
+
+#include <stddef.h>
+
+/*
+	Shader storage buffer rewritten by the CPU every frame.
+	The storage is persistently and coherently mapped and split into NUM_REGIONS regions used in turn. Each region
+	is fenced after the draws reading it, so writing a frame only waits if the GPU has fallen NUM_REGIONS frames
+	behind, and nothing goes through glBufferSubData or a map call per frame.
+*/
+class StreamBuffer
+{
+public :
+	static constexpr int NUM_REGIONS = 3;
+
+	StreamBuffer(unsigned int binding, size_t regionSize);
+	~StreamBuffer();
+
+	// Waits until the next region is no longer read by the GPU and returns it, regionSize bytes
+	void* beginWrite();
+
+	// Binds the region just written to the binding point, for the draws that follow
+	void endWrite();
+
+	// Called after the draws reading the region, which can then be written again once they complete
+	void fence();
+
+private :
+	const unsigned int binding;
+	size_t regionSize, regionStride;
+
+	unsigned int buffer;
+	unsigned char* mapping;
+
+	GLsync fences[NUM_REGIONS];
+	int region;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "trace.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	struct Event
+	{
+		const char* name;
+		Clock::time_point start, end;
+	};
+
+	struct Ring
+	{
+		unsigned int lane;
+		std::atomic<const char*> threadName;
+
+		// Written by its thread only, published to save() through numRecorded
+		std::vector<Event> events;
+		std::atomic<size_t> numRecorded;
+	};
+
+	std::atomic<bool> tracing{false};
+
+	// Rings are only freed on exit, the ones whose thread is gone wait in freeRings for the next thread
+	std::mutex ringsMutex;
+	std::vector<std::unique_ptr<Ring>> rings;
+	std::vector<Ring*> freeRings;
+
+	const Clock::time_point START_TIME = Clock::now();
+
+	// Hands its ring back once its thread exits
+	struct ThreadRing
+	{
+		Ring* ring = nullptr;
+
+		~ThreadRing()
+		{
+			if(ring)
+			{
+				std::lock_guard<std::mutex> lock{ringsMutex};
+				freeRings.push_back(ring);
+			}
+		}
+	};
+
+	thread_local ThreadRing threadRing;
+
+	Ring& ring()
+	{
+		if(!threadRing.ring)
+		{
+			std::lock_guard<std::mutex> lock{ringsMutex};
+
+			if(!freeRings.empty())
+			{
+				threadRing.ring = freeRings.back();
+				freeRings.pop_back();
+			}
+			else
+			{
+				rings.push_back(std::make_unique<Ring>());
+				threadRing.ring = rings.back().get();
+				threadRing.ring->lane = (unsigned int)rings.size();
+				threadRing.ring->events.resize(trace::RING_EVENTS);
+			}
+		}
+
+		return *threadRing.ring;
+	}
+
+	long long microseconds(Clock::time_point time)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(time - START_TIME).count();
+	}
+}
+
+void trace::enable(bool enabled)
+{
+	tracing.store(enabled, std::memory_order_relaxed);
+}
+
+bool trace::isEnabled()
+{
+	return tracing.load(std::memory_order_relaxed);
+}
+
+void trace::setThreadName(const char* name)
+{
+	if(isEnabled())
+		ring().threadName.store(name, std::memory_order_relaxed);
+}
+
+trace::Zone::Zone(const char* name) :
+	name{name}, start{}, active{isEnabled()}
+{
+	if(active)
+		start = Clock::now();
+}
+
+trace::Zone::~Zone()
+{
+	if(!active)
+		return;
+
+	Clock::time_point end = Clock::now();
+
+	Ring& threadRing = ring();
+	size_t index = threadRing.numRecorded.load(std::memory_order_relaxed);
+	threadRing.events[index % RING_EVENTS] = {name, start, end};
+	threadRing.numRecorded.store(index + 1, std::memory_order_release);
+}
+
+bool trace::save(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if(!file)
+	{
+		printf("Failed to open %s\n", path);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{ringsMutex};
+
+	fprintf(file, "{\"traceEvents\" : [\n");
+
+	bool first = true;
+	size_t numEvents = 0;
+	for(const std::unique_ptr<Ring>& threadRing : rings)
+	{
+		const char* threadName = threadRing->threadName.load(std::memory_order_relaxed);
+		if(threadName)
+		{
+			fprintf(file, "%s{\"name\" : \"thread_name\", \"ph\" : \"M\", \"pid\" : 1, \"tid\" : %u, \"args\" : {\"name\" : \"%s\"}}",
+					first ? "" : ",\n", threadRing->lane, threadName);
+			first = false;
+		}
+
+		// Only the last RING_EVENTS zones are left
+		size_t numRecorded = threadRing->numRecorded.load(std::memory_order_acquire);
+		size_t firstEvent = (numRecorded > (size_t)RING_EVENTS) ? numRecorded - RING_EVENTS : 0;
+
+		for(size_t i = firstEvent; i < numRecorded; i++)
+		{
+			const Event& event = threadRing->events[i % RING_EVENTS];
+			long long start = microseconds(event.start);
+
+			fprintf(file, "%s{\"name\" : \"%s\", \"ph\" : \"X\", \"pid\" : 1, \"tid\" : %u, \"ts\" : %lld, \"dur\" : %lld}",
+					first ? "" : ",\n", event.name, threadRing->lane, start, microseconds(event.end) - start);
+			first = false;
+		}
+
+		numEvents += numRecorded - firstEvent;
+	}
+
+	fprintf(file, "\n]}\n");
+
+	bool success = !ferror(file);
+	success &= fclose(file) == 0;
+
+	if(success)
+		printf("Traced %zu zones on %zu threads into %s\n", numEvents, rings.size(), path);
+	else
+		printf("Failed to write %s\n", path);
+
+	return success;
+}
\ No newline at end of file
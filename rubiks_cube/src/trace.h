@@ -0,0 +1,42 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <chrono>
+
+/*
+	Scoped zones saved as Chrome trace JSON, for chrome://tracing or ui.perfetto.dev.
+	Each thread records into a ring of its own holding its last RING_EVENTS zones, so recording never takes a lock.
+	A ring outlives its thread and is handed on to the next thread to start tracing, short lived workers share its lane.
+	While tracing is disabled a zone costs one relaxed load and nothing is allocated.
+*/
+namespace trace
+{
+	constexpr int RING_EVENTS = 1 << 15;
+
+	void enable(bool enabled);
+	bool isEnabled();
+
+	// Names the calling thread's lane. Zone and thread names are kept as pointers, string literals without quotes
+	void setThreadName(const char* name);
+
+	// Every ring's zones, only exact once the threads being traced have stopped recording
+	bool save(const char* path);
+
+	// Times its own scope
+	class Zone
+	{
+	private :
+		const char* name;
+		std::chrono::steady_clock::time_point start;
+		bool active;
+
+	public :
+		explicit Zone(const char* name);
+		~Zone();
+
+		Zone(const Zone&) = delete;
+		Zone& operator=(const Zone&) = delete;
+	};
+}
+
+#endif
\ No newline at end of file
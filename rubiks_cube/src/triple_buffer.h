@@ -0,0 +1,58 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/*
+	Hands the latest value from one writer thread to one reader thread without locks or waiting.
+	The writer fills writeSlot() and publishes it, the reader takes whatever was published last. Neither ever
+	touches the slot the other is using, the third one is where the latest published value waits.
+*/
+template<typename T>
+class TripleBuffer
+{
+private :
+	static constexpr unsigned int
+		INDEX_MASK = 3,
+		FRESH = 4;
+
+	T slots[3];
+
+	// The slot holding the latest published value, FRESH until the reader takes it
+	std::atomic<unsigned int> ready;
+	unsigned int back, front;
+
+public :
+	TripleBuffer() :
+		slots{}, ready{1}, back{0}, front{2}
+	{}
+
+	// Sets every slot, only while no other thread uses the buffer
+	void fill(const T& value)
+	{
+		for(T& slot : slots)
+			slot = value;
+	}
+
+	// Writer side, the slot stays the writer's until publish()
+	T& writeSlot()
+	{
+		return slots[back];
+	}
+
+	void publish()
+	{
+		back = ready.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+	}
+
+	// Reader side, the latest published value or the one read last time if nothing newer came
+	const T& read()
+	{
+		if(ready.load(std::memory_order_relaxed) & FRESH)
+			front = ready.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+
+		return slots[front];
+	}
+};
+
+#endif
\ No newline at end of file
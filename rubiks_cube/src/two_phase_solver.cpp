@@ -0,0 +1,413 @@
+#include "two_phase_solver.h"
+#include "cube_coordinates.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace
+{
+	constexpr char TABLE_MAGIC[8] = {'R', 'C', '2', 'P', 'H', 'A', 'S', 'E'};
+	constexpr size_t HEADER_SIZE = 16;
+
+	// Magic, then the version of the tables' layout and generation, bumped whenever either changes, then the
+	// coordinates' fingerprint
+	constexpr unsigned int TABLE_VERSION = 2;
+
+	void writeHeader(unsigned char* data)
+	{
+		unsigned int version[2] = {TABLE_VERSION, coordinates::fingerprint()};
+		std::memcpy(data, TABLE_MAGIC, sizeof(TABLE_MAGIC));
+		std::memcpy(data + sizeof(TABLE_MAGIC), version, sizeof(version));
+	}
+
+	bool isCurrentHeader(const unsigned char* data)
+	{
+		unsigned char header[HEADER_SIZE];
+		writeHeader(header);
+		return std::memcmp(data, header, HEADER_SIZE) == 0;
+	}
+
+	constexpr unsigned char UNVISITED = 0xFF;
+	constexpr int TIME_CHECK_INTERVAL = 1024;
+
+	constexpr int NUM_PHASE_2_MOVES = 10;
+	constexpr Move PHASE_2_MOVES[NUM_PHASE_2_MOVES]
+	{
+		MOVE_U, MOVE_U2, MOVE_U_PRIME,
+		MOVE_D, MOVE_D2, MOVE_D_PRIME,
+		MOVE_R2, MOVE_L2, MOVE_F2, MOVE_B2
+	};
+
+	constexpr Move ALL_MOVES[NUM_FACE_MOVES]
+	{
+		MOVE_R, MOVE_R2, MOVE_R_PRIME, MOVE_L, MOVE_L2, MOVE_L_PRIME,
+		MOVE_U, MOVE_U2, MOVE_U_PRIME, MOVE_D, MOVE_D2, MOVE_D_PRIME,
+		MOVE_F, MOVE_F2, MOVE_F_PRIME, MOVE_B, MOVE_B2, MOVE_B_PRIME
+	};
+
+	struct TableLayout
+	{
+		size_t twistMove, flipMove, sliceMove;
+		size_t cornerPermutationMove, edgePermutationMove, slicePermutationMove;
+		size_t twistSlicePrune, flipSlicePrune, cornerSlicePrune, edgeSlicePrune;
+		size_t size;
+	};
+
+	constexpr size_t moveTableSize(int numCoordinates)
+	{
+		return (size_t)numCoordinates * NUM_FACE_MOVES * sizeof(unsigned short);
+	}
+
+	constexpr TableLayout computeLayout()
+	{
+		using namespace coordinates;
+
+		TableLayout layout{};
+		size_t offset = HEADER_SIZE;
+
+		auto allocate = [&offset](size_t size)
+		{
+			size_t start = offset;
+			offset += (size + 7) & ~(size_t)7;
+			return start;
+		};
+
+		layout.twistMove = allocate(moveTableSize(NUM_TWISTS));
+		layout.flipMove = allocate(moveTableSize(NUM_FLIPS));
+		layout.sliceMove = allocate(moveTableSize(NUM_SLICES));
+		layout.cornerPermutationMove = allocate(moveTableSize(NUM_CORNER_PERMUTATIONS));
+		layout.edgePermutationMove = allocate(moveTableSize(NUM_EDGE_PERMUTATIONS));
+		layout.slicePermutationMove = allocate(moveTableSize(NUM_SLICE_PERMUTATIONS));
+		layout.twistSlicePrune = allocate((size_t)NUM_TWISTS * NUM_SLICES);
+		layout.flipSlicePrune = allocate((size_t)NUM_FLIPS * NUM_SLICES);
+		layout.cornerSlicePrune = allocate((size_t)NUM_CORNER_PERMUTATIONS * NUM_SLICE_PERMUTATIONS);
+		layout.edgeSlicePrune = allocate((size_t)NUM_EDGE_PERMUTATIONS * NUM_SLICE_PERMUTATIONS);
+		layout.size = offset;
+
+		return layout;
+	}
+
+	constexpr TableLayout LAYOUT = computeLayout();
+
+	inline bool isPhase2Move(Move move)
+	{
+		int face = moveFace(move);
+		return (face == 2) || (face == 3) || (moveTurn(move) == TURN_DOUBLE);
+	}
+
+	template<typename Setter, typename Getter>
+	void buildMoveTable(unsigned short* table, int numCoordinates, const Move* moves, int numMoves,
+						Setter setCoordinate, Getter getCoordinate)
+	{
+		std::fill(table, table + (size_t)numCoordinates * NUM_FACE_MOVES, 0);
+
+		for(int coordinate = 0; coordinate < numCoordinates; coordinate++)
+		{
+			CubeState state;
+			setCoordinate(state, coordinate);
+
+			for(int i = 0; i < numMoves; i++)
+			{
+				CubeState moved = state;
+				moved.applyMove(moves[i]);
+				table[(size_t)coordinate * NUM_FACE_MOVES + moves[i]] = (unsigned short)getCoordinate(moved);
+			}
+		}
+	}
+
+	// Breadth-first distances over a pair of coordinates, both solved at 0
+	void buildPruneTable(unsigned char* prune, int numFirst, int numSecond,
+						 const unsigned short* firstMove, const unsigned short* secondMove,
+						 const Move* moves, int numMoves)
+	{
+		size_t size = (size_t)numFirst * numSecond;
+		std::fill(prune, prune + size, UNVISITED);
+		prune[0] = 0;
+
+		size_t numVisited = 1;
+		for(unsigned char depth = 0; numVisited < size; depth++)
+		{
+			size_t numVisitedBefore = numVisited;
+
+			for(size_t index = 0; index < size; index++)
+			{
+				if(prune[index] != depth)
+					continue;
+
+				size_t first = index / numSecond, second = index % numSecond;
+				for(int i = 0; i < numMoves; i++)
+				{
+					size_t next = (size_t)firstMove[first * NUM_FACE_MOVES + moves[i]] * numSecond
+								  + secondMove[second * NUM_FACE_MOVES + moves[i]];
+					if(prune[next] == UNVISITED)
+					{
+						prune[next] = depth + 1;
+						numVisited++;
+					}
+				}
+			}
+
+			if(numVisited == numVisitedBefore)
+				break;
+		}
+	}
+}
+
+struct TwoPhaseSolver::Search
+{
+	const TwoPhaseSolver& solver;
+	const CubeState& start;
+	int targetLength;
+	std::chrono::steady_clock::time_point deadline;
+
+	Move path[MAX_SOLUTION_LENGTH] = {};
+	Move best[MAX_SOLUTION_LENGTH] = {};
+	int bestLength = MAX_SOLUTION_LENGTH + 1;
+
+	long long nodes = 0;
+	bool stopped = false;
+
+	void checkTime()
+	{
+		if((++nodes % TIME_CHECK_INTERVAL == 0) && (std::chrono::steady_clock::now() > deadline))
+			stopped = true;
+	}
+
+	void phase1(int twist, int flip, int slice, int depth, int remaining, int lastFace)
+	{
+		checkTime();
+		if(stopped)
+			return;
+
+		if(remaining == 0)
+		{
+			// Ending phase 1 on a phase 2 move only repeats a shorter phase 1 sequence
+			if((twist == 0) && (flip == 0) && (slice == 0) && ((depth == 0) || !isPhase2Move(path[depth - 1])))
+				startPhase2(depth);
+			return;
+		}
+
+		for(Move move : ALL_MOVES)
+		{
+			int face = moveFace(move);
+			if(isRedundantMove(face, lastFace))
+				continue;
+
+			int nextTwist = solver.twistMove[twist * NUM_FACE_MOVES + move];
+			int nextFlip = solver.flipMove[flip * NUM_FACE_MOVES + move];
+			int nextSlice = solver.sliceMove[slice * NUM_FACE_MOVES + move];
+
+			int distance = std::max(solver.twistSlicePrune[nextTwist * coordinates::NUM_SLICES + nextSlice],
+									solver.flipSlicePrune[nextFlip * coordinates::NUM_SLICES + nextSlice]);
+			if(distance > remaining - 1)
+				continue;
+
+			path[depth] = move;
+			phase1(nextTwist, nextFlip, nextSlice, depth + 1, remaining - 1, face);
+
+			if(stopped)
+				return;
+		}
+	}
+
+	void startPhase2(int phase1Length)
+	{
+		int maxPhase2Length = std::min(bestLength - 1 - phase1Length, (int)MAX_PHASE_2_LENGTH);
+		if(maxPhase2Length < 0)
+			return;
+
+		CubeState state = start;
+		state.applyMoves(path, phase1Length);
+
+		int cornerPermutation = coordinates::cornerPermutation(state);
+		int edgePermutation = coordinates::edgePermutation(state);
+		int slicePermutation = coordinates::slicePermutation(state);
+		int lastFace = (phase1Length > 0) ? moveFace(path[phase1Length - 1]) : NO_FACE;
+
+		int distance = std::max(solver.cornerSlicePrune[cornerPermutation * coordinates::NUM_SLICE_PERMUTATIONS + slicePermutation],
+								solver.edgeSlicePrune[edgePermutation * coordinates::NUM_SLICE_PERMUTATIONS + slicePermutation]);
+
+		for(int length = distance; length <= maxPhase2Length; length++)
+		{
+			if(phase2(cornerPermutation, edgePermutation, slicePermutation, phase1Length, length, lastFace))
+			{
+				bestLength = phase1Length + length;
+				std::copy(path, path + bestLength, best);
+
+				if(bestLength <= targetLength)
+					stopped = true;
+				return;
+			}
+		}
+	}
+
+	bool phase2(int cornerPermutation, int edgePermutation, int slicePermutation, int depth, int remaining, int lastFace)
+	{
+		if(remaining == 0)
+			return (cornerPermutation == 0) && (edgePermutation == 0) && (slicePermutation == 0);
+
+		for(Move move : PHASE_2_MOVES)
+		{
+			int face = moveFace(move);
+			if(isRedundantMove(face, lastFace))
+				continue;
+
+			int nextCornerPermutation = solver.cornerPermutationMove[cornerPermutation * NUM_FACE_MOVES + move];
+			int nextEdgePermutation = solver.edgePermutationMove[edgePermutation * NUM_FACE_MOVES + move];
+			int nextSlicePermutation = solver.slicePermutationMove[slicePermutation * NUM_FACE_MOVES + move];
+
+			int distance = std::max(solver.cornerSlicePrune[nextCornerPermutation * coordinates::NUM_SLICE_PERMUTATIONS + nextSlicePermutation],
+									solver.edgeSlicePrune[nextEdgePermutation * coordinates::NUM_SLICE_PERMUTATIONS + nextSlicePermutation]);
+			if(distance > remaining - 1)
+				continue;
+
+			path[depth] = move;
+			if(phase2(nextCornerPermutation, nextEdgePermutation, nextSlicePermutation, depth + 1, remaining - 1, face))
+				return true;
+		}
+
+		return false;
+	}
+};
+
+TwoPhaseSolver::TwoPhaseSolver() :
+	tableFile{}, tableBuffer{},
+	twistMove{nullptr}, flipMove{nullptr}, sliceMove{nullptr},
+	cornerPermutationMove{nullptr}, edgePermutationMove{nullptr}, slicePermutationMove{nullptr},
+	twistSlicePrune{nullptr}, flipSlicePrune{nullptr}, cornerSlicePrune{nullptr}, edgeSlicePrune{nullptr}
+{}
+
+bool TwoPhaseSolver::loadTables(const char* path)
+{
+	trace::Zone zone{"two-phase loadTables"};
+
+	if(tableFile.open(path))
+	{
+		if((tableFile.size() == LAYOUT.size) && isCurrentHeader(tableFile.data()))
+		{
+			assignTables(tableFile.data());
+			return true;
+		}
+
+		printf("Ignoring stale two-phase solver tables in %s\n", path);
+		tableFile.close();
+	}
+
+	printf("Generating two-phase solver tables into %s\n", path);
+
+	tableBuffer.assign(LAYOUT.size, 0);
+	generateTables(tableBuffer.data());
+
+	if(MappedFile::write(path, tableBuffer.data(), tableBuffer.size()) && tableFile.open(path))
+	{
+		tableBuffer.clear();
+		tableBuffer.shrink_to_fit();
+		assignTables(tableFile.data());
+		return true;
+	}
+
+	printf("Keeping the two-phase solver tables in memory only\n");
+	assignTables(tableBuffer.data());
+	return false;
+}
+
+bool TwoPhaseSolver::isReady() const
+{
+	return twistMove != nullptr;
+}
+
+void TwoPhaseSolver::assignTables(const unsigned char* data)
+{
+	twistMove = (const unsigned short*)(data + LAYOUT.twistMove);
+	flipMove = (const unsigned short*)(data + LAYOUT.flipMove);
+	sliceMove = (const unsigned short*)(data + LAYOUT.sliceMove);
+	cornerPermutationMove = (const unsigned short*)(data + LAYOUT.cornerPermutationMove);
+	edgePermutationMove = (const unsigned short*)(data + LAYOUT.edgePermutationMove);
+	slicePermutationMove = (const unsigned short*)(data + LAYOUT.slicePermutationMove);
+
+	twistSlicePrune = data + LAYOUT.twistSlicePrune;
+	flipSlicePrune = data + LAYOUT.flipSlicePrune;
+	cornerSlicePrune = data + LAYOUT.cornerSlicePrune;
+	edgeSlicePrune = data + LAYOUT.edgeSlicePrune;
+}
+
+void TwoPhaseSolver::generateTables(unsigned char* data)
+{
+	using namespace coordinates;
+
+	writeHeader(data);
+
+	unsigned short* twistMoveTable = (unsigned short*)(data + LAYOUT.twistMove);
+	unsigned short* flipMoveTable = (unsigned short*)(data + LAYOUT.flipMove);
+	unsigned short* sliceMoveTable = (unsigned short*)(data + LAYOUT.sliceMove);
+	unsigned short* cornerPermutationMoveTable = (unsigned short*)(data + LAYOUT.cornerPermutationMove);
+	unsigned short* edgePermutationMoveTable = (unsigned short*)(data + LAYOUT.edgePermutationMove);
+	unsigned short* slicePermutationMoveTable = (unsigned short*)(data + LAYOUT.slicePermutationMove);
+
+	buildMoveTable(twistMoveTable, NUM_TWISTS, ALL_MOVES, NUM_FACE_MOVES, setTwist, twist);
+	buildMoveTable(flipMoveTable, NUM_FLIPS, ALL_MOVES, NUM_FACE_MOVES, setFlip, flip);
+	buildMoveTable(sliceMoveTable, NUM_SLICES, ALL_MOVES, NUM_FACE_MOVES, setSlice, slice);
+	buildMoveTable(cornerPermutationMoveTable, NUM_CORNER_PERMUTATIONS, PHASE_2_MOVES, NUM_PHASE_2_MOVES,
+				   setCornerPermutation, cornerPermutation);
+	buildMoveTable(edgePermutationMoveTable, NUM_EDGE_PERMUTATIONS, PHASE_2_MOVES, NUM_PHASE_2_MOVES,
+				   setEdgePermutation, edgePermutation);
+	buildMoveTable(slicePermutationMoveTable, NUM_SLICE_PERMUTATIONS, PHASE_2_MOVES, NUM_PHASE_2_MOVES,
+				   setSlicePermutation, slicePermutation);
+
+	buildPruneTable(data + LAYOUT.twistSlicePrune, NUM_TWISTS, NUM_SLICES,
+					twistMoveTable, sliceMoveTable, ALL_MOVES, NUM_FACE_MOVES);
+	buildPruneTable(data + LAYOUT.flipSlicePrune, NUM_FLIPS, NUM_SLICES,
+					flipMoveTable, sliceMoveTable, ALL_MOVES, NUM_FACE_MOVES);
+	buildPruneTable(data + LAYOUT.cornerSlicePrune, NUM_CORNER_PERMUTATIONS, NUM_SLICE_PERMUTATIONS,
+					cornerPermutationMoveTable, slicePermutationMoveTable, PHASE_2_MOVES, NUM_PHASE_2_MOVES);
+	buildPruneTable(data + LAYOUT.edgeSlicePrune, NUM_EDGE_PERMUTATIONS, NUM_SLICE_PERMUTATIONS,
+					edgePermutationMoveTable, slicePermutationMoveTable, PHASE_2_MOVES, NUM_PHASE_2_MOVES);
+}
+
+bool TwoPhaseSolver::solve(const CubeState& state, MoveSequence& solution, int targetLength, float timeLimitSeconds) const
+{
+	trace::Zone zone{"two-phase solve"};
+
+	if(!isReady())
+	{
+		printf("Two-phase solver tables are not loaded\n");
+		return false;
+	}
+
+	// The search works on the cube turned so its centers are home, and its face moves are mapped back
+	CubeState homed = state;
+	Move faceMoves[NUM_FACE_MOVES];
+	if(!homed.rotateCentersHome(faceMoves) || !homed.isSolvable())
+	{
+		printf("Cannot solve an unreachable cube state\n");
+		return false;
+	}
+
+	Search search{*this, homed, targetLength,
+				  std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					  std::chrono::duration<float>{timeLimitSeconds})};
+
+	int twist = coordinates::twist(homed);
+	int flip = coordinates::flip(homed);
+	int slice = coordinates::slice(homed);
+
+	for(int phase1Length = 0; (phase1Length <= MAX_SOLUTION_LENGTH) && (phase1Length < search.bestLength); phase1Length++)
+	{
+		trace::Zone lengthZone{"two-phase phase 1 length"};
+		search.phase1(twist, flip, slice, 0, phase1Length, NO_FACE);
+		if(search.stopped)
+			break;
+	}
+
+	if(search.bestLength > MAX_SOLUTION_LENGTH)
+		return false;
+
+	for(int i = 0; i < search.bestLength; i++)
+		search.best[i] = faceMoves[search.best[i]];
+
+	solution.assign(search.best, search.bestLength);
+	return true;
+}
\ No newline at end of file
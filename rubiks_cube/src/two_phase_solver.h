@@ -0,0 +1,61 @@
+#ifndef TWO_PHASE_SOLVER_H
+#define TWO_PHASE_SOLVER_H
+
+#include "cube_state.h"
+#include "mapped_file.h"
+#include "move_sequence.h"
+
+#include <vector>
+
+/*
+	Kociemba's two-phase algorithm.
+	Phase 1 reaches the subgroup <U, D, R2, L2, F2, B2> (no twist, no flip, slice edges in the slice),
+	phase 2 solves within it. Phase 1 keeps producing longer entry sequences and every shorter total is kept
+	until the target length or the time limit is reached.
+	Move and pruning tables are generated on first use, written to disk and memory-mapped afterwards.
+*/
+class TwoPhaseSolver
+{
+public :
+	static constexpr int
+		DEFAULT_TARGET_LENGTH = 21,
+		MAX_PHASE_2_LENGTH = 18,
+		MAX_SOLUTION_LENGTH = 30;
+
+	static constexpr float DEFAULT_TIME_LIMIT_SECONDS = 1.0f;
+
+	TwoPhaseSolver();
+
+	// Maps the tables from path, or generates them when it is missing or holds tables from another version or build,
+	// and writes them there. Returns false if they could not be written, they are then kept in memory only
+	bool loadTables(const char* path);
+	bool isReady() const;
+
+	// Returns the shortest solution found, which is at most targetLength moves unless the time limit ran out first.
+	// Face moves only : a cube whose centers were moved is solved around them and stays turned
+	bool solve(const CubeState& state, MoveSequence& solution,
+			   int targetLength = DEFAULT_TARGET_LENGTH, float timeLimitSeconds = DEFAULT_TIME_LIMIT_SECONDS) const;
+
+private :
+	struct Search;
+
+	MappedFile tableFile;
+	std::vector<unsigned char> tableBuffer;
+
+	const unsigned short* twistMove;
+	const unsigned short* flipMove;
+	const unsigned short* sliceMove;
+	const unsigned short* cornerPermutationMove;
+	const unsigned short* edgePermutationMove;
+	const unsigned short* slicePermutationMove;
+
+	const unsigned char* twistSlicePrune;
+	const unsigned char* flipSlicePrune;
+	const unsigned char* cornerSlicePrune;
+	const unsigned char* edgeSlicePrune;
+
+	void assignTables(const unsigned char* data);
+	static void generateTables(unsigned char* data);
+};
+
+#endif
\ No newline at end of file
@@ -1,8 +1,127 @@
 #include "util.h"
+#include "mapped_file.h"
+#include "embedded_shaders.h"
+#include "trace.h"
 
 #include <stdio.h>
+#include <cstring>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr char PROGRAM_CACHE_MAGIC[8] = {'R', 'C', 'P', 'R', 'O', 'G', 'B', 'N'};
+
+	// Magic, key, binary format, then the binary
+	struct ProgramCacheHeader
+	{
+		char magic[8];
+		unsigned long long key;
+		unsigned int binaryFormat;
+		unsigned int padding;
+	};
+
+	static_assert(sizeof(ProgramCacheHeader) == 24, "ProgramCacheHeader is written to disk as is");
+
+	bool readFile(const char* path, std::string& contents)
+	{
+		std::ifstream file{path};
+		if(!file.is_open())
+			return false;
+
+		std::stringstream sstream;
+		sstream << file.rdbuf();
+		contents = sstream.str();
+		return true;
+	}
+
+	// FNV-1a, continued from hash
+	unsigned long long hashBytes(unsigned long long hash, const void* data, size_t size)
+	{
+		const unsigned char* bytes = (const unsigned char*)data;
+		for(size_t i = 0; i < size; i++)
+			hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+
+		return hash;
+	}
+
+	unsigned long long hashString(unsigned long long hash, const char* string)
+	{
+		// Includes the terminator, so "ab" + "c" and "a" + "bc" differ
+		return hashBytes(hash, string ? string : "", string ? std::strlen(string) + 1 : 1);
+	}
+
+	// A binary is only valid for the sources it was built from and the driver that built it
+	unsigned long long programCacheKey(const char* vertexSource, const char* fragmentSource)
+	{
+		unsigned long long hash = 0xCBF29CE484222325ull;
+		hash = hashString(hash, vertexSource);
+		hash = hashString(hash, fragmentSource);
+		hash = hashString(hash, (const char*)glGetString(GL_VENDOR));
+		hash = hashString(hash, (const char*)glGetString(GL_RENDERER));
+		hash = hashString(hash, (const char*)glGetString(GL_VERSION));
+		hash = hashString(hash, (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
+		return hash;
+	}
+
+	bool isLinked(unsigned int program)
+	{
+		int success;
+		glGetProgramiv(program, GL_LINK_STATUS, &success);
+		return success == GL_TRUE;
+	}
+
+	unsigned int loadCachedProgram(const char* cachePath, unsigned long long key)
+	{
+		MappedFile cache;
+		if(!cache.open(cachePath))
+			return 0;
+
+		ProgramCacheHeader header;
+		if(cache.size() <= sizeof(header))
+			return 0;
+
+		std::memcpy(&header, cache.data(), sizeof(header));
+		if((std::memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC)) != 0) || (header.key != key))
+			return 0;
+
+		unsigned int program = glCreateProgram();
+		glProgramBinary(program, header.binaryFormat, cache.data() + sizeof(header), (GLsizei)(cache.size() - sizeof(header)));
+
+		// The driver may still refuse a binary it wrote, after an update that kept its version string
+		if(!isLinked(program))
+		{
+			glDeleteProgram(program);
+			return 0;
+		}
+
+		return program;
+	}
+
+	void cacheProgram(const char* cachePath, unsigned long long key, unsigned int program)
+	{
+		int binaryLength = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if(binaryLength <= 0)
+			return;
+
+		std::vector<unsigned char> data(sizeof(ProgramCacheHeader) + binaryLength);
+
+		ProgramCacheHeader header{};
+		std::memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(PROGRAM_CACHE_MAGIC));
+		header.key = key;
+
+		GLenum binaryFormat;
+		glGetProgramBinary(program, binaryLength, &binaryLength, &binaryFormat, data.data() + sizeof(header));
+		header.binaryFormat = binaryFormat;
+		std::memcpy(data.data(), &header, sizeof(header));
+
+		if(!MappedFile::write(cachePath, data.data(), sizeof(header) + binaryLength))
+			printf("Failed to write shader program cache %s\n", cachePath);
+	}
+}
 
 void glDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, 
 					 GLsizei length, const GLchar* message, const void* userParam)
@@ -10,8 +129,13 @@ void glDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
 	printf("OpenGL debug message : %s\n", message);
 }
 
-GLFWwindow* initialize(int windowWidth, int windowHeight, const char* title, int majorVersion, int minorVersion)
+GLFWwindow* initialize(int windowWidth, int windowHeight, const char* title, int majorVersion, int minorVersion,
+					   bool headless)
 {
+#ifdef GLEW_OSMESA
+	glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
+
 	if(glfwInit() != GLFW_TRUE)
 	{
 		printf("Failed to initialize GLFW\n");
@@ -21,6 +145,11 @@ GLFWwindow* initialize(int windowWidth, int windowHeight, const char* title, int
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+	glfwWindowHint(GLFW_VISIBLE, headless ? GLFW_FALSE : GLFW_TRUE);
+
+#ifdef GLEW_OSMESA
+	glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
 
 	GLFWwindow* window = glfwCreateWindow(windowWidth, windowHeight, title, nullptr, nullptr);
 	if(!window)
@@ -42,26 +171,37 @@ GLFWwindow* initialize(int windowWidth, int windowHeight, const char* title, int
 	return window;
 }
 
-unsigned int compileShader(unsigned int type, const char* path)
+bool loadShader(const char* name, const char* overrideDirectory, std::string& source)
 {
-	std::ifstream file;
-	file.open(path);
-	std::stringstream sstream;
-	std::string source;
+	trace::Zone zone{"loadShader"};
 
-	if(!file.is_open())
+	if(overrideDirectory)
 	{
-		printf("Failed to open shader file\n");
-		return 0;
-	} 
-	else
+		std::string path = std::string{overrideDirectory} + "/" + name;
+		if(!readFile(path.c_str(), source))
+		{
+			printf("Failed to open shader file %s\n", path.c_str());
+			return false;
+		}
+
+		return true;
+	}
+
+	for(const EmbeddedShader& shader : EMBEDDED_SHADERS)
 	{
-		sstream << file.rdbuf();
-		source = sstream.str();
+		if(std::strcmp(shader.name, name) == 0)
+		{
+			source = shader.source;
+			return true;
+		}
 	}
 
-	const char* sourceStr = source.c_str();
+	printf("No embedded shader named %s\n", name);
+	return false;
+}
 
+unsigned int compileShader(unsigned int type, const char* sourceStr)
+{
 	unsigned int shader = glCreateShader(type);
 	glShaderSource(shader, 1, &sourceStr, nullptr);
 	glCompileShader(shader);
@@ -91,12 +231,31 @@ unsigned int compileShader(unsigned int type, const char* path)
 	return shader;
 }
 
-unsigned int createShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath)
+unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource, const char* cachePath)
 {
-	unsigned int vshader = compileShader(GL_VERTEX_SHADER, vertexShaderPath);
-	unsigned int fshader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderPath);
+	trace::Zone zone{"createShaderProgram"};
+
+	// Drivers without any binary format can't cache programs
+	int numBinaryFormats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numBinaryFormats);
+	if(numBinaryFormats <= 0)
+		cachePath = nullptr;
+
+	unsigned long long cacheKey = cachePath ? programCacheKey(vertexSource, fragmentSource) : 0;
+	if(cachePath)
+	{
+		unsigned int program = loadCachedProgram(cachePath, cacheKey);
+		if(program)
+			return program;
+	}
+
+	unsigned int vshader = compileShader(GL_VERTEX_SHADER, vertexSource);
+	unsigned int fshader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
 
 	unsigned int program = glCreateProgram();
+	if(cachePath)
+		glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	glAttachShader(program, vshader);
 	glAttachShader(program, fshader);
 	glLinkProgram(program);
@@ -126,5 +285,8 @@ unsigned int createShaderProgram(const char* vertexShaderPath, const char* fragm
 	glDeleteShader(vshader);
 	glDeleteShader(fshader);
 
+	if(cachePath && isLinked(program))
+		cacheProgram(cachePath, cacheKey, program);
+
 	return program;
 }
\ No newline at end of file
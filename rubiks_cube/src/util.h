@@ -4,12 +4,24 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include <string>
+
 void glDebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity, 
 					 GLsizei length, const GLchar* message, const void* userParam);
 
-GLFWwindow* initialize(int windowWidth, int windowHeight, const char* title, int majorVersion, int minorVersion);
+// A headless window is never shown. Builds whose GLEW loads through OSMesa create it on GLFW's null platform,
+// which needs no display at all
+GLFWwindow* initialize(int windowWidth, int windowHeight, const char* title, int majorVersion, int minorVersion,
+					   bool headless = false);
+
+// The shader built into the executable from rubiks_cube/res, or the file of that name in overrideDirectory if there is one,
+// to try out shader changes without rebuilding
+bool loadShader(const char* name, const char* overrideDirectory, std::string& source);
+
+unsigned int compileShader(unsigned int type, const char* source);
 
-unsigned int compileShader(unsigned int type, const char* path);
-unsigned int createShaderProgram(const char* vertexShaderPath, const char* fragmentShaderPath);
+// With a cachePath the linked program binary is kept there and loaded instead of compiling, as long as the sources
+// and the driver are the same as when it was written
+unsigned int createShaderProgram(const char* vertexSource, const char* fragmentSource, const char* cachePath = nullptr);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,313 @@
+#include "cube_state.h"
+#include "facelet_cube.h"
+#include "move_sequence.h"
+#include "notation.h"
+#include "optimal_solver.h"
+#include "two_phase_solver.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Checks of rubiks_core, run by ctest from the build directory. Every failure is printed, any one fails the run
+namespace
+{
+	int numFailures = 0;
+
+	void check(bool condition, const char* format, ...)
+	{
+		if(condition)
+			return;
+
+		va_list arguments;
+		va_start(arguments, format);
+		printf("FAILED : ");
+		vprintf(format, arguments);
+		printf("\n");
+		va_end(arguments);
+
+		numFailures++;
+	}
+
+	std::vector<Move> randomMoves(std::mt19937& random, int numMoves, int numKinds)
+	{
+		std::uniform_int_distribution<int> moveDistribution{0, numKinds - 1};
+
+		std::vector<Move> moves(numMoves);
+		for(Move& move : moves)
+			move = (Move)moveDistribution(random);
+		return moves;
+	}
+
+	// Any move four times over is no move at all, a quarter turn is only undone by the fourth
+	template<typename Cube>
+	void checkMoveOrders(const char* cubeName)
+	{
+		for(int move = 0; move < NUM_MOVES; move++)
+		{
+			Cube cube;
+			for(int turn = 1; turn <= 4; turn++)
+			{
+				cube.applyMove((Move)move);
+
+				bool solvedExpected = (turn == 4) || ((turn == 2) && (moveTurn((Move)move) == TURN_DOUBLE));
+				check(cube.isSolved() == solvedExpected, "%s : move %d applied %d times is %s", cubeName, move, turn,
+					  cube.isSolved() ? "solved" : "not solved");
+			}
+		}
+	}
+
+	// applyMoves() uses whichever kernel the build targets
+	void checkFaceletKernels(std::mt19937& random)
+	{
+		for(int sequence = 0; sequence < 1000; sequence++)
+		{
+			std::vector<Move> moves = randomMoves(random, 1 + sequence % 100, NUM_MOVES);
+
+			FaceletCube kernel, scalar, oneByOne;
+			kernel.applyMoves(moves.data(), moves.size());
+			scalar.applyMovesScalar(moves.data(), moves.size());
+			for(Move move : moves)
+				oneByOne.applyMove(move);
+
+			check(kernel == scalar, "facelet kernel and scalar kernel disagree on sequence %d", sequence);
+			check(oneByOne == scalar, "facelet moves one by one and scalar kernel disagree on sequence %d", sequence);
+		}
+	}
+
+	void checkTwoPhaseSolves(std::mt19937& random)
+	{
+		TwoPhaseSolver solver;
+		solver.loadTables("two_phase_solver.tables");
+		check(solver.isReady(), "two-phase solver tables not loaded");
+		if(!solver.isReady())
+			return;
+
+		for(int scramble = 0; scramble < 25; scramble++)
+		{
+			std::vector<Move> moves = randomMoves(random, 30, NUM_FACE_MOVES);
+
+			CubeState state;
+			state.applyMoves(moves.data(), moves.size());
+
+			MoveSequence solution;
+			bool solved = solver.solve(state, solution);
+			check(solved, "two-phase solver found no solution for scramble %d", scramble);
+			if(!solved)
+				continue;
+
+			state.applyMoves(solution.data(), solution.size());
+			check(state.isSolved(), "two-phase solution of scramble %d leaves the cube unsolved", scramble);
+			check((int)solution.size() <= TwoPhaseSolver::DEFAULT_TARGET_LENGTH, "two-phase solution of scramble %d has %zu moves",
+				  scramble, solution.size());
+		}
+
+		// A slice, then any moves : the solution is face moves that solve the cube around its centers where they are
+		for(int scramble = 0; scramble < 25; scramble++)
+		{
+			std::vector<Move> moves = randomMoves(random, scramble, NUM_MOVES);
+
+			CubeState state;
+			state.applyMove(MOVE_M);
+			state.applyMoves(moves.data(), moves.size());
+
+			MoveSequence solution;
+			bool solved = solver.solve(state, solution);
+			check(solved, "two-phase solver found no solution for slice scramble %d", scramble);
+			if(!solved)
+				continue;
+
+			check(std::all_of(solution.begin(), solution.end(), [](Move move) { return move < NUM_FACE_MOVES; }),
+				  "two-phase solution of slice scramble %d has moves other than face moves", scramble);
+
+			state.applyMoves(solution.data(), solution.size());
+			bool rotated = state.rotateCentersHome(nullptr);
+			check(rotated && state.isSolved(), "two-phase solution of slice scramble %d leaves the cube unsolved", scramble);
+		}
+	}
+
+	void checkNotationRoundTrip(std::mt19937& random)
+	{
+		for(int sequence = 0; sequence < 1000; sequence++)
+		{
+			std::vector<Move> moves = randomMoves(random, sequence % 50, NUM_MOVES);
+			MoveSequence written{moves.data(), moves.size()};
+
+			std::string text = notation::format(written);
+
+			MoveSequence read;
+			size_t errorOffset = 0;
+			bool parsed = notation::parse(text.c_str(), read, &errorOffset);
+
+			check(parsed, "\"%s\" fails to parse at offset %zu", text.c_str(), errorOffset);
+			check(parsed && (read == written), "\"%s\" reads back as \"%s\"", text.c_str(), notation::format(read).c_str());
+		}
+
+		// Depths only go on face and wide turns
+		std::uniform_int_distribution<int> depthDistribution{0, 255};
+		for(int sequence = 0; sequence < 1000; sequence++)
+		{
+			std::vector<LayerMove> written;
+			for(Move move : randomMoves(random, sequence % 50, NUM_MOVES))
+			{
+				int family = moveFace(move);
+				bool faceOrWide = (family < FAMILY_SLICE) || ((family >= FAMILY_WIDE) && (family < FAMILY_ROTATION));
+				written.push_back({move, (unsigned char)(faceOrWide ? depthDistribution(random) : 0)});
+			}
+
+			std::string text;
+			notation::format(written.data(), written.size(), text);
+
+			std::vector<LayerMove> read;
+			size_t errorOffset = 0;
+			bool parsed = notation::parse(text.c_str(), text.size(), read, &errorOffset);
+
+			bool same = parsed && (read.size() == written.size());
+			for(size_t i = 0; same && (i < read.size()); i++)
+				same = (read[i].move == written[i].move) && (read[i].depth == written[i].depth);
+
+			check(parsed, "\"%s\" fails to parse at offset %zu", text.c_str(), errorOffset);
+			check(same, "\"%s\" reads back with other moves or depths", text.c_str());
+		}
+	}
+
+	constexpr int HALF_DEPTH = 4;
+
+	using StateKey = std::array<unsigned char, 2 * (CubeState::NUM_CORNERS + CubeState::NUM_EDGES)>;
+
+	// Face moves leave the centers home, the other arrays tell the states apart
+	StateKey stateKey(const CubeState& state)
+	{
+		StateKey key;
+		unsigned char* out = key.data();
+		out = std::copy(state.cornerPermutation, state.cornerPermutation + CubeState::NUM_CORNERS, out);
+		out = std::copy(state.cornerOrientation, state.cornerOrientation + CubeState::NUM_CORNERS, out);
+		out = std::copy(state.edgePermutation, state.edgePermutation + CubeState::NUM_EDGES, out);
+		std::copy(state.edgeOrientation, state.edgeOrientation + CubeState::NUM_EDGES, out);
+		return key;
+	}
+
+	// Every state up to maxDepth face moves away, some more than once, reached without redundant moves
+	template<typename Visit>
+	void forEachNearby(const CubeState& state, int depth, int maxDepth, int lastFace, const Visit& visit)
+	{
+		visit(state, depth);
+		if(depth == maxDepth)
+			return;
+
+		for(int move = 0; move < NUM_FACE_MOVES; move++)
+		{
+			int face = moveFace((Move)move);
+			if(isRedundantMove(face, lastFace))
+				continue;
+
+			CubeState next = state;
+			next.applyMove((Move)move);
+			forEachNearby(next, depth + 1, maxDepth, face, visit);
+		}
+	}
+
+	// The optimal solver's answers against brute force, meeting in the middle : a state up to 2 * HALF_DEPTH moves from
+	// solved is HALF_DEPTH moves or less from one of the states HALF_DEPTH moves or less from solved
+	void checkOptimalSolves(std::mt19937& random)
+	{
+		OptimalSolver solver;
+		solver.loadTables("optimal_solver.tables");
+		check(solver.isReady(), "optimal solver tables not loaded");
+		if(!solver.isReady())
+			return;
+
+		std::vector<Move> moves = randomMoves(random, 20, NUM_FACE_MOVES);
+		CubeState farState;
+		farState.applyMoves(moves.data(), moves.size());
+
+		// A cancel() that lands before solve() starts still stops it
+		MoveSequence solution;
+		solver.cancel();
+		check(!solver.solve(farState, solution), "optimal solve after cancel() was not cancelled");
+
+		// As does one from another thread while it runs, a 20-move scramble would otherwise take far too long
+		OptimalSolver::Statistics statistics{};
+		std::thread canceller{[&solver]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			solver.cancel();
+		}};
+		bool solved = solver.solve(farState, solution, OptimalSolver::NO_TIME_LIMIT, 0, &statistics);
+		canceller.join();
+		check(!solved, "optimal solve of a 20-move scramble was not cancelled");
+		check(statistics.nodes > 0, "cancelled optimal solve counted no nodes");
+
+		std::map<StateKey, int> nearSolved;
+		forEachNearby(CubeState{}, 0, HALF_DEPTH, NO_FACE, [&nearSolved](const CubeState& state, int depth)
+		{
+			auto [entry, inserted] = nearSolved.emplace(stateKey(state), depth);
+			entry->second = std::min(entry->second, depth);
+		});
+
+		for(int scramble = 0; scramble < 32; scramble++)
+		{
+			moves = randomMoves(random, 1 + scramble % (2 * HALF_DEPTH), NUM_FACE_MOVES);
+
+			CubeState state;
+			state.applyMoves(moves.data(), moves.size());
+
+			int optimalLength = 2 * HALF_DEPTH;
+			forEachNearby(state, 0, HALF_DEPTH, NO_FACE, [&nearSolved, &optimalLength](const CubeState& reached, int depth)
+			{
+				auto entry = nearSolved.find(stateKey(reached));
+				if(entry != nearSolved.end())
+					optimalLength = std::min(optimalLength, depth + entry->second);
+			});
+
+			statistics = {};
+			solved = solver.solve(state, solution, OptimalSolver::NO_TIME_LIMIT, 0, &statistics);
+			check(solved, "optimal solver found no solution for scramble %d", scramble);
+			if(!solved)
+				continue;
+
+			check((int)solution.size() == optimalLength, "optimal solution of scramble %d has %zu moves instead of %d", scramble,
+				  solution.size(), optimalLength);
+			check((optimalLength == 0) || (statistics.nodes > 0), "optimal solve of scramble %d counted no nodes", scramble);
+
+			state.applyMoves(solution.data(), solution.size());
+			check(state.isSolved(), "optimal solution of scramble %d leaves the cube unsolved", scramble);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::mt19937 random{20240917};
+
+	// The optimal solver's tables take a while to generate, so its checks run on their own
+	if((argc > 1) && (std::strcmp(argv[1], "optimal") == 0))
+	{
+		checkOptimalSolves(random);
+	}
+	else
+	{
+		checkMoveOrders<CubeState>("CubeState");
+		checkMoveOrders<FaceletCube>("FaceletCube");
+		checkFaceletKernels(random);
+		checkTwoPhaseSolves(random);
+		checkNotationRoundTrip(random);
+	}
+
+	if(numFailures > 0)
+	{
+		printf("%d checks failed\n", numFailures);
+		return 1;
+	}
+
+	printf("All checks passed\n");
+	return 0;
+}
\ No newline at end of file